@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+#include "BigInt.h"
+
+static void Trim(std::vector<uint32_t>& limbs)
+{
+    while (!limbs.empty() && limbs.back() == 0)
+        limbs.pop_back();
+}
+
+// Of trimmed magnitudes.
+static int CompareMagnitudes(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b)
+{
+    if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
+
+    for (size_t st = a.size(); st-- > 0; )
+    {
+        if (a[st] != b[st])
+            return a[st] < b[st] ? -1 : 1;
+    }
+    return 0;
+}
+
+// out = a + b, out has max(an, bn) + 1 limbs.
+static void AddMagnitudes(const uint32_t* a, size_t an, const uint32_t* b, size_t bn, uint32_t* out)
+{
+    if (an < bn)
+    {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+
+    uint32_t carry = 0;
+    for (size_t st = 0; st < an; st++)
+    {
+        uint32_t sum = a[st] + (st < bn ? b[st] : 0) + carry;
+        carry = sum >= BigIntBase;
+        out[st] = carry ? sum - BigIntBase : sum;
+    }
+    out[an] = carry;
+}
+
+// a += b, the sum fits in an limbs.
+static void AddInPlace(uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    uint32_t carry = 0;
+    for (size_t st = 0; st < an && (st < bn || carry); st++)
+    {
+        uint32_t sum = a[st] + (st < bn ? b[st] : 0) + carry;
+        carry = sum >= BigIntBase;
+        a[st] = carry ? sum - BigIntBase : sum;
+    }
+    assert(carry == 0);
+}
+
+// a -= b, a >= b.
+static void SubtractInPlace(uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    uint32_t borrow = 0;
+    for (size_t st = 0; st < an && (st < bn || borrow); st++)
+    {
+        uint32_t subtrahend = (st < bn ? b[st] : 0) + borrow;
+        borrow = a[st] < subtrahend;
+        a[st] = borrow ? a[st] + BigIntBase - subtrahend : a[st] - subtrahend;
+    }
+    assert(borrow == 0);
+}
+
+// out = a * b, out has an + bn limbs. Products are summed in 64 bits and the carries are
+// propagated once per SchoolbookRows rows of a.
+static void MultiplySchoolbook(const uint32_t* a, size_t an, const uint32_t* b, size_t bn, uint32_t* out)
+{
+    std::vector<uint64_t> sums(an + bn);
+    for (size_t first = 0; first < an; first += SchoolbookRows)
+    {
+        size_t last = std::min(an, first + SchoolbookRows);
+        for (size_t st = first; st < last; st++)
+        {
+            uint64_t factor = a[st];
+            for (size_t col = 0; col < bn; col++)
+                sums[st + col] += factor * b[col];
+        }
+
+        uint64_t carry = 0;
+        for (size_t st = first; st < an + bn && (carry || st < last + bn); st++)
+        {
+            uint64_t value = sums[st] + carry;
+            sums[st] = value % BigIntBase;
+            carry = value / BigIntBase;
+        }
+    }
+
+    for (size_t st = 0; st < an + bn; st++)
+        out[st] = static_cast<uint32_t>(sums[st]);
+}
+
+// out = a * b, out has an + bn limbs. The three products of large Karatsuba steps are OpenMP tasks.
+static void MultiplyMagnitudes(const uint32_t* a, size_t an, const uint32_t* b, size_t bn, uint32_t* out)
+{
+    if (an < bn)
+    {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+
+    if (bn < KaratsubaThreshold)
+    {
+        MultiplySchoolbook(a, an, b, bn, out);
+        return;
+    }
+
+    // Unbalanced factors: pieces of a by b.
+    if (2 * bn <= an)
+    {
+        std::fill(out, out + an + bn, 0);
+        std::vector<uint32_t> piece(2 * bn);
+        for (size_t st = 0; st < an; st += bn)
+        {
+            size_t count = std::min(bn, an - st);
+            MultiplyMagnitudes(a + st, count, b, bn, piece.data());
+            AddInPlace(out + st, an + bn - st, piece.data(), count + bn);
+        }
+        return;
+    }
+
+    // a = a1 B^m + a0, b = b1 B^m + b0, b1 is not empty as bn > an / 2.
+    size_t m = an / 2;
+    const uint32_t* a1 = a + m;
+    const uint32_t* b1 = b + m;
+    size_t a1n = an - m;
+    size_t b1n = bn - m;
+
+    std::vector<uint32_t> sumA(a1n + 1);
+    std::vector<uint32_t> sumB(std::max(m, b1n) + 1);
+    AddMagnitudes(a, m, a1, a1n, sumA.data());
+    AddMagnitudes(b, m, b1, b1n, sumB.data());
+    std::vector<uint32_t> middle(sumA.size() + sumB.size());
+
+    // a0 b0 and a1 b1 go to the low and the high limbs of out.
+    bool parallel = an >= KaratsubaTaskThreshold;
+    #pragma omp task if(parallel)
+    MultiplyMagnitudes(a, m, b, m, out);
+    #pragma omp task if(parallel)
+    MultiplyMagnitudes(a1, a1n, b1, b1n, out + 2 * m);
+    MultiplyMagnitudes(sumA.data(), sumA.size(), sumB.data(), sumB.size(), middle.data());
+    #pragma omp taskwait
+
+    SubtractInPlace(middle.data(), middle.size(), out, 2 * m);
+    SubtractInPlace(middle.data(), middle.size(), out + 2 * m, a1n + b1n);
+    Trim(middle);
+    AddInPlace(out + m, an + bn - m, middle.data(), middle.size());
+}
+
+BigInt::BigInt(int64_t value) :
+    Negative(value < 0)
+{
+    uint64_t magnitude = value < 0 ? -static_cast<uint64_t>(value) : value;
+    while (magnitude > 0)
+    {
+        Limbs.push_back(static_cast<uint32_t>(magnitude % BigIntBase));
+        magnitude /= BigIntBase;
+    }
+}
+
+std::string BigInt::ToString() const
+{
+    if (Limbs.empty())
+        return "0";
+
+    std::string digits = std::to_string(Limbs.back());
+    char limb[BigIntBaseDigits + 1];
+    for (size_t st = Limbs.size() - 1; st-- > 0; )
+    {
+        snprintf(limb, sizeof(limb), "%09u", Limbs[st]);
+        digits += limb;
+    }
+    return digits;
+}
+
+static BigInt AddSigned(const BigInt& a, const BigInt& b, bool negateB)
+{
+    bool bNegative = b.Negative != negateB;
+
+    BigInt result;
+    if (a.Negative == bNegative)
+    {
+        result.Limbs.resize(std::max(a.Size(), b.Size()) + 1);
+        AddMagnitudes(a.Limbs.data(), a.Size(), b.Limbs.data(), b.Size(), result.Limbs.data());
+        result.Negative = a.Negative;
+    }
+    else
+    {
+        int order = CompareMagnitudes(a.Limbs, b.Limbs);
+        const BigInt& larger = order >= 0 ? a : b;
+        const BigInt& smaller = order >= 0 ? b : a;
+
+        result.Limbs = larger.Limbs;
+        SubtractInPlace(result.Limbs.data(), result.Size(), smaller.Limbs.data(), smaller.Size());
+        result.Negative = order >= 0 ? a.Negative : bNegative;
+    }
+
+    Trim(result.Limbs);
+    result.Negative = result.Negative && !result.IsZero();
+    return result;
+}
+
+BigInt operator + (const BigInt& a, const BigInt& b)
+{
+    return AddSigned(a, b, false);
+}
+
+BigInt operator - (const BigInt& a, const BigInt& b)
+{
+    return AddSigned(a, b, true);
+}
+
+BigInt operator * (const BigInt& a, const BigInt& b)
+{
+    BigInt result;
+    if (a.IsZero() || b.IsZero())
+        return result;
+
+    result.Limbs.resize(a.Size() + b.Size());
+    MultiplyMagnitudes(a.Limbs.data(), a.Size(), b.Limbs.data(), b.Size(), result.Limbs.data());
+    Trim(result.Limbs);
+    result.Negative = a.Negative != b.Negative;
+    return result;
+}
+
+void MultiplySmall(BigInt& a, uint32_t factor)
+{
+    uint64_t carry = 0;
+    for (uint32_t& limb : a.Limbs)
+    {
+        uint64_t value = static_cast<uint64_t>(limb) * factor + carry;
+        limb = static_cast<uint32_t>(value % BigIntBase);
+        carry = value / BigIntBase;
+    }
+    for (; carry > 0; carry /= BigIntBase)
+        a.Limbs.push_back(static_cast<uint32_t>(carry % BigIntBase));
+
+    Trim(a.Limbs);
+    a.Negative = a.Negative && !a.IsZero();
+}
+
+BigFloat Truncate(const BigInt& a, size_t limbs)
+{
+    BigFloat result;
+    result.Mantissa = a;
+    if (a.Size() > limbs)
+    {
+        size_t dropped = a.Size() - limbs;
+        result.Mantissa.Limbs.erase(result.Mantissa.Limbs.begin(), result.Mantissa.Limbs.begin() + dropped);
+        result.Exponent = dropped;
+    }
+    return result;
+}
+
+BigFloat Truncate(const BigFloat& a, size_t limbs)
+{
+    BigFloat result = Truncate(a.Mantissa, limbs);
+    result.Exponent += a.Exponent;
+    return result;
+}
+
+// Mantissa with shift zero limbs below.
+static BigInt ShiftUp(const BigInt& a, int64_t shift)
+{
+    BigInt result = a;
+    if (!a.IsZero())
+        result.Limbs.insert(result.Limbs.begin(), shift, 0);
+    return result;
+}
+
+BigFloat Add(const BigFloat& a, const BigFloat& b, size_t limbs)
+{
+    int64_t exponent = std::min(a.Exponent, b.Exponent);
+
+    BigFloat result;
+    result.Mantissa = ShiftUp(a.Mantissa, a.Exponent - exponent) + ShiftUp(b.Mantissa, b.Exponent - exponent);
+    result.Exponent = exponent;
+    return Truncate(result, limbs);
+}
+
+BigFloat Multiply(const BigFloat& a, const BigFloat& b, size_t limbs)
+{
+    BigFloat x = Truncate(a, limbs);
+    BigFloat y = Truncate(b, limbs);
+
+    BigFloat result;
+    result.Mantissa = x.Mantissa * y.Mantissa;
+    result.Exponent = x.Exponent + y.Exponent;
+    return Truncate(result, limbs);
+}
+
+static BigFloat Negated(const BigFloat& a)
+{
+    BigFloat result = a;
+    result.Mantissa.Negative = !a.Mantissa.Negative && !a.Mantissa.IsZero();
+    return result;
+}
+
+// value * BigIntBase^exponent, value > 0, with about 16 digits.
+static BigFloat FromDouble(double value, int64_t exponent)
+{
+    for (; value >= 1e18; exponent++)
+        value /= BigIntBase;
+    for (; value < 1e9; exponent--)
+        value *= BigIntBase;
+
+    BigFloat result;
+    result.Mantissa = BigInt(static_cast<int64_t>(value));
+    result.Exponent = exponent;
+    return result;
+}
+
+// a = value * BigIntBase^exponent, value is taken from the top limbs.
+static double ToDouble(const BigFloat& a, int64_t& exponent)
+{
+    size_t size = a.Mantissa.Size();
+    size_t top = std::min<size_t>(size, 3);
+
+    double value = 0;
+    for (size_t st = size; st-- > size - top; )
+        value = value * BigIntBase + a.Mantissa.Limbs[st];
+
+    exponent = a.Exponent + static_cast<int64_t>(size - top);
+    return a.Mantissa.Negative ? -value : value;
+}
+
+// Starting from a double the precision is about 1.7 limbs, every iteration doubles it.
+
+BigFloat Reciprocal(const BigFloat& a, size_t limbs)
+{
+    assert(!a.Mantissa.IsZero());
+
+    int64_t exponent = 0;
+    double value = ToDouble(a, exponent);
+    BigFloat x = FromDouble(1 / std::abs(value), -exponent);
+    x.Mantissa.Negative = value < 0;
+
+    BigFloat one;
+    one.Mantissa = BigInt(1);
+
+    for (size_t precision = 1; precision < limbs; )
+    {
+        precision = std::min(2 * precision, limbs);
+        size_t guarded = precision + 2;
+
+        // x += x (1 - a x).
+        BigFloat error = Add(one, Negated(Multiply(a, x, guarded)), guarded);
+        x = Add(x, Multiply(x, error, guarded), guarded);
+    }
+    return x;
+}
+
+BigFloat InverseSqrt(const BigFloat& a, size_t limbs)
+{
+    assert(!a.Mantissa.IsZero() && !a.Mantissa.Negative);
+
+    int64_t exponent = 0;
+    double value = ToDouble(a, exponent);
+    if (exponent % 2 != 0)
+    {
+        value *= BigIntBase;
+        exponent--;
+    }
+    BigFloat x = FromDouble(1 / std::sqrt(value), -exponent / 2);
+
+    BigFloat one;
+    one.Mantissa = BigInt(1);
+
+    for (size_t precision = 1; precision < limbs; )
+    {
+        precision = std::min(2 * precision, limbs);
+        size_t guarded = precision + 2;
+
+        // x += x (1 - a x^2) / 2.
+        BigFloat error = Add(one, Negated(Multiply(a, Multiply(x, x, guarded), guarded)), guarded);
+        MultiplySmall(error.Mantissa, BigIntBase / 2);
+        error.Exponent--;
+        x = Add(x, Multiply(x, error, guarded), guarded);
+    }
+    return x;
+}
\ No newline at end of file
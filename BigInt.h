@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Limbs are base 10^9, so decimal digits are printed limb by limb.
+const uint32_t BigIntBase = 1000000000;
+const size_t BigIntBaseDigits = 9;
+
+// Rows of a schoolbook product summed before the carries, 16 products of limbs and a limb fit in 64 bits.
+const size_t SchoolbookRows = 16;
+
+// Smaller products are multiplied by the schoolbook method.
+const size_t KaratsubaThreshold = 128;
+
+// Halves of Karatsuba products of at least this many limbs are OpenMP tasks.
+const size_t KaratsubaTaskThreshold = 4096;
+
+// Signed integer, the lowest limb first. Zero has no limbs and is not negative.
+struct BigInt
+{
+    std::vector<uint32_t> Limbs;
+    bool Negative = false;
+
+    BigInt() = default;
+    explicit BigInt(int64_t value);
+
+    bool IsZero() const
+    {
+        return Limbs.empty();
+    }
+
+    size_t Size() const
+    {
+        return Limbs.size();
+    }
+
+    // Decimal digits of the magnitude.
+    std::string ToString() const;
+};
+
+BigInt operator + (const BigInt& a, const BigInt& b);
+BigInt operator - (const BigInt& a, const BigInt& b);
+// Karatsuba multiplication. Called inside an OpenMP parallel region it spreads over the threads.
+BigInt operator * (const BigInt& a, const BigInt& b);
+
+// a *= factor.
+void MultiplySmall(BigInt& a, uint32_t factor);
+
+// Mantissa * BigIntBase^Exponent, mantissas are truncated to a given number of limbs.
+struct BigFloat
+{
+    BigInt Mantissa;
+    int64_t Exponent = 0;
+};
+
+// Top limbs of a, the value is truncated toward zero.
+BigFloat Truncate(const BigInt& a, size_t limbs);
+BigFloat Truncate(const BigFloat& a, size_t limbs);
+
+BigFloat Add(const BigFloat& a, const BigFloat& b, size_t limbs);
+BigFloat Multiply(const BigFloat& a, const BigFloat& b, size_t limbs);
+
+// 1 / a and 1 / sqrt(a) by Newton iterations that double the precision up to limbs.
+BigFloat Reciprocal(const BigFloat& a, size_t limbs);
+BigFloat InverseSqrt(const BigFloat& a, size_t limbs);
\ No newline at end of file
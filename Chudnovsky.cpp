@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <omp.h>
+
+#include "Chudnovsky.h"
+
+const char* const PiPrefix =
+    "1415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679";
+
+// 640320^3 / 24.
+static const int64_t ChudnovskyQFactor = 10939058860032000;
+
+size_t GetChudnovskyTermsCount(size_t digits)
+{
+    return static_cast<size_t>(digits / ChudnovskyTermDigits) + 2;
+}
+
+// Term k >= 1: P = -(6k-5)(2k-1)(6k-1), Q = k^3 640320^3 / 24, T = P (13591409 + 545140134k).
+// Factors fit in 32 bits for k < 7e8, i.e. below 10^10 digits.
+static SplitTerms GetTerm(size_t k)
+{
+    SplitTerms term;
+
+    term.P = BigInt(6 * k - 5);
+    MultiplySmall(term.P, static_cast<uint32_t>(2 * k - 1));
+    MultiplySmall(term.P, static_cast<uint32_t>(6 * k - 1));
+    term.P.Negative = true;
+
+    term.Q = BigInt(ChudnovskyQFactor);
+    for (size_t st = 0; st < 3; st++)
+        MultiplySmall(term.Q, static_cast<uint32_t>(k));
+
+    term.T = term.P * BigInt(13591409 + 545140134 * static_cast<int64_t>(k));
+    return term;
+}
+
+// Products of large merges are OpenMP tasks, the multiplications spread further.
+static void Merge(SplitTerms& left, const SplitTerms& right)
+{
+    bool parallel = left.Q.Size() >= KaratsubaTaskThreshold;
+
+    BigInt p;
+    BigInt q;
+    BigInt t1;
+    BigInt t2;
+    #pragma omp task shared(p, left, right) if(parallel)
+    p = left.P * right.P;
+    #pragma omp task shared(q, left, right) if(parallel)
+    q = left.Q * right.Q;
+    #pragma omp task shared(t1, left, right) if(parallel)
+    t1 = left.T * right.Q;
+    t2 = left.P * right.T;
+    #pragma omp taskwait
+
+    left.P = std::move(p);
+    left.Q = std::move(q);
+    left.T = t1 + t2;
+}
+
+static void Split(size_t first, size_t last, SplitTerms& terms)
+{
+    if (last - first == 1)
+    {
+        terms = GetTerm(first);
+        return;
+    }
+
+    size_t middle = (first + last) / 2;
+    SplitTerms right;
+    #pragma omp task shared(terms) if(last - first > SplitTaskTerms)
+    Split(first, middle, terms);
+    Split(middle, last, right);
+    #pragma omp taskwait
+
+    Merge(terms, right);
+}
+
+SplitTerms SplitChudnovsky(size_t first, size_t last, size_t threadsCount)
+{
+    SplitTerms terms = {BigInt(1), BigInt(1), BigInt()};
+    if (first >= last)
+        return terms;
+
+    #pragma omp parallel num_threads(threadsCount)
+    #pragma omp single
+    Split(first, last, terms);
+
+    return terms;
+}
+
+void MergeSplitTerms(SplitTerms& left, const SplitTerms& right, size_t threadsCount)
+{
+    #pragma omp parallel num_threads(threadsCount)
+    #pragma omp single
+    Merge(left, right);
+}
+
+std::string GetPiDigits(const SplitTerms& terms, size_t digits, size_t threadsCount)
+{
+    // Guard limbs take the truncation errors.
+    size_t limbs = digits / BigIntBaseDigits + 4;
+
+    // pi = 426880 sqrt(10005) Q / (13591409 Q + T), the term k = 0 is in the denominator.
+    BigInt denominator = terms.Q;
+    MultiplySmall(denominator, 13591409);
+    denominator = denominator + terms.T;
+
+    BigFloat constant;
+    constant.Mantissa = BigInt(10005);
+
+    BigFloat pi;
+    #pragma omp parallel num_threads(threadsCount)
+    #pragma omp single
+    {
+        BigFloat inverse;
+        BigFloat root;
+        #pragma omp task shared(inverse)
+        inverse = Reciprocal(Truncate(denominator, limbs + 2), limbs);
+        root = Multiply(constant, InverseSqrt(constant, limbs), limbs);
+        #pragma omp taskwait
+
+        pi = Multiply(Multiply(Truncate(terms.Q, limbs), inverse, limbs), root, limbs);
+        MultiplySmall(pi.Mantissa, 426880);
+    }
+
+    // The mantissa has a digit before the point.
+    std::string mantissa = pi.Mantissa.ToString();
+    int64_t integerDigits = static_cast<int64_t>(mantissa.size()) + pi.Exponent * static_cast<int64_t>(BigIntBaseDigits);
+    if (integerDigits != 1 || mantissa.size() < digits + 1)
+        return "";
+
+    return mantissa.substr(0, 1) + "." + mantissa.substr(1, digits);
+}
+
+size_t CheckPiDigits(const std::string& pi)
+{
+    if (pi.compare(0, 2, "3.") != 0)
+        return 0;
+
+    size_t count = 0;
+    while (PiPrefix[count] && count + 2 < pi.size() && pi[count + 2] == PiPrefix[count])
+        count++;
+    return count;
+}
+
+bool ReportPiDigits(const std::string& pi, size_t digits, double computeTime)
+{
+    if (pi.empty())
+    {
+        std::cout << "Pi is lost in the rounding, digits are not computed." << std::endl;
+        return false;
+    }
+
+    const size_t shownDigits = 50;
+    size_t expected = std::min(digits, strlen(PiPrefix));
+    size_t checked = CheckPiDigits(pi);
+
+    std::cout
+        << "Computed pi     = " << pi.substr(0, shownDigits + 2) << (digits > shownDigits ? "..." : "") << "\n";
+    if (digits > shownDigits)
+        std::cout << "Last digits     = ..." << pi.substr(pi.size() - std::min(digits - shownDigits, shownDigits)) << "\n";
+
+    std::cout
+        << "Checked digits  = " << checked << " of " << expected << (checked == expected ? ", OK" : ", FAILED") << "\n"
+        << std::scientific
+        << std::setprecision(3)
+        << "Digits per second = " << static_cast<double>(digits) / computeTime
+        << std::endl;
+
+    return checked == expected;
+}
\ No newline at end of file
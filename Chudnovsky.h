@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "BigInt.h"
+
+// Decimal digits added by a term of the Chudnovsky series, log10(640320^3 / 1728).
+const double ChudnovskyTermDigits = 14.181647462725477;
+
+// Splits of at most this many terms are not parallel tasks.
+const size_t SplitTaskTerms = 64;
+
+// Known digits of pi after the point.
+extern const char* const PiPrefix;
+
+// Binary splitting sums of the terms [first, last) of
+// \frac{ 1 }{ \pi } = \frac{ 12 }{ 640320^{3/2} } \sum_{k=0}^{+\infty} \frac{ (-1)^k (6k)! (13591409 + 545140134k) }{ (3k)! (k!)^3 640320^{3k} }.
+// Neighbour ranges are merged by MergeSplitTerms, the empty range is P = Q = 1, T = 0.
+struct SplitTerms
+{
+    BigInt P;
+    BigInt Q;
+    BigInt T;
+};
+
+// Terms for digits digits after the point.
+size_t GetChudnovskyTermsCount(size_t digits);
+
+// Terms [first, last) by threadsCount OpenMP threads, first >= 1.
+SplitTerms SplitChudnovsky(size_t first, size_t last, size_t threadsCount);
+
+// Merges the terms of [a, m) and [m, b) to [a, b) in left by threadsCount OpenMP threads.
+void MergeSplitTerms(SplitTerms& left, const SplitTerms& right, size_t threadsCount);
+
+// pi from the terms [1, N) with digits digits after the point, e.g. "3.1415".
+std::string GetPiDigits(const SplitTerms& terms, size_t digits, size_t threadsCount);
+
+// Leading digits after the point of pi that match PiPrefix.
+size_t CheckPiDigits(const std::string& pi);
+
+// Prints the head and the tail of pi, its check against PiPrefix and digits per second.
+// Returns false if the check fails.
+bool ReportPiDigits(const std::string& pi, size_t digits, double computeTime);
\ No newline at end of file
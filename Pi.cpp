@@ -4,8 +4,15 @@
 #include <numbers>
 #include <string>
 #include <sstream>
+#include <cstring>
+#include <vector>
 #include <mpi.h>
 
+#include "Chudnovsky.h"
+#include "PiSeries.h"
+#include "common/metrics.h"
+#include "common/mpi_reduction.h"
+
 #define EXEC_MPI(action)                              \
     {                                                 \
         int _mpi_err_code = action;                   \
@@ -38,7 +45,213 @@ static inline std::string DoubleToString(double number, std::streamsize prec = 3
 }
 
 static const int ROOT_PROC_RANK  = 0;
-static const int PARTIAL_SUM_TAG = 1;
+static const int SPLIT_TERMS_TAG = 1;
+
+static void PrintPi(double pi)
+{
+    std::cout 
+        << "Computed pi  = "
+        << DoubleToString(pi)
+        << "\n"
+
+        << "Reference pi = "
+        << DoubleToString(std::numbers::pi)
+        << "\n"
+
+        << "Difference   = "
+        << DoubleToString(pi - std::numbers::pi)
+        << "\n"
+
+        << "Accuracy     = "
+        << std::scientific
+        << std::setprecision(2)
+        << (pi - std::numbers::pi) / std::numbers::pi * 100.0
+        << "%"
+        << std::endl;
+}
+
+// [Negative, limbs count, limbs...] of P, Q and T.
+static void SendSplitTerms(const SplitTerms& terms, int destRank)
+{
+    std::vector<uint32_t> buffer;
+    for (const BigInt* value : {&terms.P, &terms.Q, &terms.T})
+    {
+        buffer.push_back(value->Negative);
+        buffer.push_back(static_cast<uint32_t>(value->Size()));
+        buffer.insert(buffer.end(), value->Limbs.begin(), value->Limbs.end());
+    }
+
+    EXEC_MPI(MPI_Send(buffer.data(), static_cast<int>(buffer.size()), MPI_UINT32_T, destRank, SPLIT_TERMS_TAG, MPI_COMM_WORLD));
+}
+
+static SplitTerms ReceiveSplitTerms(int sourceRank)
+{
+    MPI_Status status;
+    int count = 0;
+    EXEC_MPI(MPI_Probe(sourceRank, SPLIT_TERMS_TAG, MPI_COMM_WORLD, &status));
+    EXEC_MPI(MPI_Get_count(&status, MPI_UINT32_T, &count));
+
+    std::vector<uint32_t> buffer(count);
+    EXEC_MPI(MPI_Recv(buffer.data(), count, MPI_UINT32_T, sourceRank, SPLIT_TERMS_TAG, MPI_COMM_WORLD, &status));
+
+    SplitTerms terms;
+    size_t position = 0;
+    for (BigInt* value : {&terms.P, &terms.Q, &terms.T})
+    {
+        value->Negative = buffer[position];
+        size_t size = buffer[position + 1];
+        value->Limbs.assign(buffer.begin() + position + 2, buffer.begin() + position + 2 + size);
+        position += 2 + size;
+    }
+    return terms;
+}
+
+// Plain sums need about 1 / (2 tolerance) terms, their error is 4 / (8N).
+static void PrintAcceleratedSum(const AcceleratedSum& sum, double tolerance)
+{
+    // The difference of the diagonal values may be 0, the sum is not known better than its rounding.
+    double error = 4 * std::max(sum.Error, std::abs(sum.Value) * DBL_EPSILON);
+    std::cout
+        << std::scientific
+        << std::setprecision(2)
+        << "Estimated error = " << error << (sum.Converged ? "" : ", the tolerance is not reached in double") << "\n"
+        << "Terms = " << sum.TermsCount << ", extrapolation levels = " << sum.Levels << "\n";
+
+    if (sum.Converged)
+    {
+        double plainTermsCount = 1 / (2 * tolerance);
+        std::cout << "Plain sum terms = " << plainTermsCount << ", saved " << plainTermsCount / static_cast<double>(sum.TermsCount) << " times\n";
+    }
+    std::cout << std::flush;
+}
+
+// pi with error below the tolerance by Richardson extrapolation of the partial sums.
+// Every block of terms is split over the processes and threads, all processes get its sum.
+static int ComputeAcceleratedPi(int argc, char* argv[], int procRank, int procsCount, SumMode sumMode, double progExecTimeStart)
+{
+    if (argc != 3 && argc != 4)
+    {
+        if (procRank == ROOT_PROC_RANK)
+            std::cout 
+                << "Enter tolerance as a second argument and count of threads per process as an optional third one." 
+                << std::endl;
+        EXEC_MPI(MPI_Finalize());
+        return -1;
+    }
+
+    double tolerance = std::stod(argv[2]);
+    size_t threadsCount = argc == 4 ? std::stoul(argv[3]) : 1;
+
+    AcceleratedSum sum = AccelerateSum(tolerance / 4, [&](size_t first, size_t last)
+    {
+        size_t procFirst = 0;
+        size_t procLast = 0;
+        GetSeriesPart(first, last, procRank, procsCount, procFirst, procLast);
+
+        SumAccumulator blockSum = SumPiSeries(procFirst, procLast, threadsCount, sumMode);
+        EXEC_MPI(CollectSum(blockSum, -1, MPI_COMM_WORLD));
+        return blockSum.Get();
+    });
+
+    if (procRank == ROOT_PROC_RANK)
+    {
+        double progExecTime = MPI_Wtime() - progExecTimeStart;
+        RunMetrics()
+            .Add("time", progExecTime)
+            .Add("procs", procsCount)
+            .Add("threads", threadsCount)
+            .Add("terms", sum.TermsCount)
+            .Add("error", 4 * sum.Error)
+            .Save();
+
+        PrintPi(4 * sum.Value);
+        std::cout
+            << std::endl;
+        PrintAcceleratedSum(sum, tolerance);
+
+        std::cout
+            << "Summation = " << GetSumModeName(sumMode) << "\n"
+            << std::endl
+            << std::fixed
+            << std::setprecision(6)
+            << "Program execution time = " << progExecTime << " seconds."
+            << std::endl;
+    }
+
+    EXEC_MPI(MPI_Finalize());
+    return sum.Converged ? 0 : -1;
+}
+
+// Digits of pi by the Chudnovsky series. Processes split contiguous ranges of the terms by threads,
+// the ranges are merged in a binary tree by rank: rank + step sends its range to rank.
+static int ComputePiDigits(int argc, char* argv[], int procRank, int procsCount, double progExecTimeStart)
+{
+    if (argc != 3 && argc != 4)
+    {
+        if (procRank == ROOT_PROC_RANK)
+            std::cout 
+                << "Enter count of digits as a second argument and count of threads per process as an optional third one." 
+                << std::endl;
+        EXEC_MPI(MPI_Finalize());
+        return -1;
+    }
+
+    size_t digits = static_cast<size_t>(std::stod(argv[2]));
+    size_t threadsCount = argc == 4 ? std::stoul(argv[3]) : 1;
+    size_t termsCount = GetChudnovskyTermsCount(digits);
+
+    size_t procFirst = 1 + (termsCount - 1) * procRank / procsCount;
+    size_t procLast = 1 + (termsCount - 1) * (procRank + 1) / procsCount;
+    SplitTerms terms = SplitChudnovsky(procFirst, procLast, threadsCount);
+    double splitTimeStop = MPI_Wtime();
+
+    for (int step = 1; step < procsCount; step *= 2)
+    {
+        if (procRank % (2 * step) == step)
+        {
+            SendSplitTerms(terms, procRank - step);
+            break;
+        }
+        if (procRank + step < procsCount)
+            MergeSplitTerms(terms, ReceiveSplitTerms(procRank + step), threadsCount);
+    }
+    double mergeTimeStop = MPI_Wtime();
+
+    bool checked = true;
+    if (procRank == ROOT_PROC_RANK)
+    {
+        std::string pi = GetPiDigits(terms, digits, threadsCount);
+        double progExecTimeStop = MPI_Wtime();
+
+        std::cout
+            << "Digits = " << digits << ", terms = " << termsCount
+            << ", processes = " << procsCount << ", threads per process = " << threadsCount << "\n"
+            << std::endl;
+
+        checked = ReportPiDigits(pi, digits, progExecTimeStop - progExecTimeStart);
+
+        RunMetrics()
+            .Add("time", progExecTimeStop - progExecTimeStart)
+            .Add("split_time", splitTimeStop - progExecTimeStart)
+            .Add("merge_time", mergeTimeStop - splitTimeStop)
+            .Add("procs", procsCount)
+            .Add("threads", threadsCount)
+            .Add("digits", digits)
+            .Save();
+
+        std::cout
+            << std::endl
+            << std::fixed
+            << std::setprecision(6)
+            << "Binary splitting time  = " << splitTimeStop - progExecTimeStart << " seconds.\n"
+            << "Merge time             = " << mergeTimeStop - splitTimeStop << " seconds.\n"
+            << "Program execution time = " << progExecTimeStop - progExecTimeStart << " seconds."
+            << std::endl;
+    }
+
+    EXEC_MPI(MPI_Finalize());
+    return checked ? 0 : -1;
+}
 
 int main(int argc, char* argv[])
 {
@@ -50,74 +263,82 @@ int main(int argc, char* argv[])
     EXEC_MPI(MPI_Init(&argc, &argv));
     EXEC_MPI(MPI_Comm_size(MPI_COMM_WORLD, &procsCount));
     EXEC_MPI(MPI_Comm_rank(MPI_COMM_WORLD, &procRank));
+
+    SumMode sumMode = SumMode::Plain;
+    if (!TakeSumModeArgument(argc, argv, sumMode))
+    {
+        if (procRank == ROOT_PROC_RANK)
+            std::cout << "Unknown summation, enter sum=plain, sum=neumaier or sum=exact." << std::endl;
+        EXEC_MPI(MPI_Finalize());
+        return -1;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "chudnovsky") == 0)
+        return ComputePiDigits(argc, argv, procRank, procsCount, progExecTimeStart);
+
+    if (argc > 1 && strcmp(argv[1], "richardson") == 0)
+        return ComputeAcceleratedPi(argc, argv, procRank, procsCount, sumMode, progExecTimeStart);
     
-    if (argc != 2)
+    if (argc != 2 && argc != 3)
     {
         std::cout 
-            << "Enter count of terms in series as a first argument. Exponential (10^9 = 1e9) notation is possible." 
+            << "Enter count of terms in series as a first argument. Exponential (10^9 = 1e9) notation is possible.\n"
+            << "Enter count of threads per process as an optional second argument, 1 by default.\n"
+            << "Enter chudnovsky as the first argument to compute digits of pi,\n"
+            << "or richardson to sum the series up to a tolerance by Richardson extrapolation.\n"
+            << "Enter sum=plain, sum=neumaier or sum=exact to choose the summation of partial sums, plain by default.\n"
+            << "Exact sums are the same for any count of processes and threads." 
             << std::endl;
         return -1;
     }
 
     size_t opersCount = static_cast<size_t>(std::stod(argv[1]));
+    size_t threadsCount = argc == 3 ? std::stoul(argv[2]) : 1;
 
-    size_t procOpersCount = opersCount / procsCount;
-    double sum = 0;
-
-    if (procRank == ROOT_PROC_RANK)
-        procOpersCount += opersCount - procOpersCount * procsCount;
-
-    for (size_t n = procRank * procOpersCount; n < (procRank + 1) * procOpersCount; n += 1)
-    {
-        sum += 2.0 / static_cast<double>((4*n + 1) * (4*n + 3));
-    }
-
-    // size_t procOpersCount = opersCount / procsCount;
-    // double sum = 0;
+    // Processes sum contiguous parts of the series, threads split them further, see PiSeries.h.
+    // Partial sums are merged in rank order by one collective, see common/mpi_reduction.h.
+    size_t procFirst = 0;
+    size_t procLast = 0;
+    GetSeriesPart(0, opersCount, procRank, procsCount, procFirst, procLast);
 
-    // if (procRank == ROOT_PROC_RANK)
-    //     procOpersCount += opersCount - procOpersCount * procsCount;
+    double computeTimeStart = MPI_Wtime();
+    SumAccumulator sum = SumPiSeries(procFirst, procLast, threadsCount, sumMode);
+    EXEC_MPI(CollectSum(sum, ROOT_PROC_RANK, MPI_COMM_WORLD));
+    double computeTime = MPI_Wtime() - computeTimeStart;
 
-    // for (size_t n = procRank; n < procOpersCount; n += procsCount)
-    // {
-    //     sum += 2.0 / static_cast<double>((4*n + 1) * (4*n + 3));
-    // }
+    // Counters of the ranks, see common/counters.h.
+    PrintCounters("RANK[" + std::to_string(procRank) + "]");
 
     if (procRank == ROOT_PROC_RANK)
     {
-        for (int st = 0; st < procsCount - 1; st++)
-        {
-            double partialSum = 0;
-            MPI_Status status;
-            EXEC_MPI(MPI_Recv(&partialSum, 1, MPI_DOUBLE, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status));
-            sum += partialSum;
-        }
+        double pi = sum.Get() * 4;
 
-        double pi = sum * 4;
+        PrintPi(pi);
 
-        std::cout 
-            << "Computed pi  = "
-            << DoubleToString(pi)
-            << "\n"
-
-            << "Reference pi = "
-            << DoubleToString(std::numbers::pi)
-            << "\n"
-
-            << "Difference   = "
-            << DoubleToString(pi - std::numbers::pi)
-            << "\n"
+        double progExecTimeStop = MPI_Wtime();
 
-            << "Accuracy     = "
-            << std::scientific
-            << std::setprecision(2)
-            << (pi - std::numbers::pi) / std::numbers::pi * 100.0
-            << "%"
+        std::cout
             << std::endl;
 
-        double progExecTimeStop = MPI_Wtime();
+        double termsPerSecond = static_cast<double>(opersCount) / computeTime;
+        RunMetrics metrics;
+        metrics
+            .Add("time", progExecTimeStop - progExecTimeStart)
+            .Add("compute_time", computeTime)
+            .Add("procs", procsCount)
+            .Add("threads", threadsCount)
+            .Add("terms", opersCount)
+            .Add("terms_per_second", termsPerSecond);
+        AddCounterMetrics(metrics);
+        metrics.Save();
 
         std::cout
+            << "Processes = " << procsCount << ", threads per process = " << threadsCount
+            << ", summation = " << GetSumModeName(sumMode) << "\n"
+            << std::scientific
+            << std::setprecision(3)
+            << "Terms per second          = " << termsPerSecond << "\n"
+            << "Terms per second per core = " << termsPerSecond / static_cast<double>(procsCount * threadsCount)
             << std::endl;
 
         std::cout
@@ -128,10 +349,6 @@ int main(int argc, char* argv[])
             << " seconds."
             << std::endl;
     }
-    else
-    {
-        EXEC_MPI(MPI_Send(&sum, 1, MPI_DOUBLE, ROOT_PROC_RANK, PARTIAL_SUM_TAG, MPI_COMM_WORLD));
-    }
 
     EXEC_MPI(MPI_Finalize());
     return 0;
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <omp.h>
+
+#include "common/counters.h"
+#include "common/reduction.h"
+
+// Independent accumulators of a thread. GCC vectorizes the loop over them (8 AVX vectors
+// with -mavx, 4 AVX-512 ones with -mavx512f), so the divisions of the terms are pipelined.
+const size_t PiSeriesLanes = 32;
+
+// Term of \pi / 4 = \sum_{n=0}^{+\infty} \frac{ 2 }{ (4n+1)(4n+3) } in double,
+// the product of size_t overflows for n > 2^30. 4n+1 is exact below 2^51.
+inline double GetPiTerm(double n)
+{
+    double x = 4 * n;
+    return 2.0 / ((x + 1) * (x + 3));
+}
+
+// Flops of a term and its addition, for the counters of the SumPiTerms region.
+const double PiTermFlops = 6;
+
+// Sum of the terms n in [first, last) by the calling thread.
+inline double SumPiTerms(size_t first, size_t last)
+{
+    double sums[PiSeriesLanes] = {};
+    // n of the lanes in double, AVX has no conversions of 64 bit integers.
+    double terms[PiSeriesLanes];
+    for (size_t lane = 0; lane < PiSeriesLanes; lane++)
+        terms[lane] = static_cast<double>(first + lane);
+
+    size_t n = first;
+    for (; n + PiSeriesLanes <= last; n += PiSeriesLanes)
+    {
+        for (size_t lane = 0; lane < PiSeriesLanes; lane++)
+        {
+            sums[lane] += GetPiTerm(terms[lane]);
+            terms[lane] += PiSeriesLanes;
+        }
+    }
+
+    double sum = 0;
+    for (; n < last; n++)
+        sum += GetPiTerm(static_cast<double>(n));
+
+    for (size_t lane = 0; lane < PiSeriesLanes; lane++)
+        sum += sums[lane];
+    return sum;
+}
+
+// Terms are summed by SumPiTerms in blocks [k PiSeriesBlockTerms, (k + 1) PiSeriesBlockTerms),
+// processes and threads take whole blocks. Block sums do not depend on the split, so exact sums
+// of them are the same for any count of processes and threads.
+const size_t PiSeriesBlockTerms = 1 << 16;
+
+// Part [partFirst, partLast) of the terms [first, last) split into partsCount parts by blocks.
+inline void GetSeriesPart(size_t first, size_t last, size_t part, size_t partsCount, size_t& partFirst, size_t& partLast)
+{
+    size_t firstBlock = first / PiSeriesBlockTerms;
+    size_t blocksCount = (last + PiSeriesBlockTerms - 1) / PiSeriesBlockTerms - firstBlock;
+
+    partFirst = std::max(first, (firstBlock + blocksCount * part / partsCount) * PiSeriesBlockTerms);
+    partLast = std::max(partFirst, std::min(last, (firstBlock + blocksCount * (part + 1) / partsCount) * PiSeriesBlockTerms));
+}
+
+// Adds the sums of the blocks of the terms [first, last) to sum.
+inline void SumPiBlocks(size_t first, size_t last, SumAccumulator& sum)
+{
+    while (first < last)
+    {
+        size_t blockLast = std::min(last, (first / PiSeriesBlockTerms + 1) * PiSeriesBlockTerms);
+        sum += SumPiTerms(first, blockLast);
+        first = blockLast;
+    }
+}
+
+// Sum of the terms n in [first, last) by threadsCount threads. Threads sum contiguous parts,
+// the parts are merged in a binary tree by thread index, see common/reduction.h.
+inline SumAccumulator SumPiSeries(size_t first, size_t last, size_t threadsCount, SumMode mode = SumMode::Plain)
+{
+    std::vector<SumAccumulator> sums(threadsCount, SumAccumulator(mode));
+
+    #pragma omp parallel for schedule(static) num_threads(threadsCount)
+    for (size_t st = 0; st < threadsCount; st++)
+    {
+        size_t threadFirst = 0;
+        size_t threadLast = 0;
+        GetSeriesPart(first, last, st, threadsCount, threadFirst, threadLast);
+
+        CounterRegion region("SumPiTerms", PiTermFlops * static_cast<double>(threadLast - threadFirst));
+        SumPiBlocks(threadFirst, threadLast, sums[st]);
+    }
+
+    return ReduceTree(std::move(sums));
+}
+
+// Removes the argument sum=plain|neumaier|exact from argv if it is there.
+// Returns false on an unknown mode.
+inline bool TakeSumModeArgument(int& argc, char* argv[], SumMode& mode)
+{
+    const char* prefix = "sum=";
+    for (int st = 1; st < argc; st++)
+    {
+        if (strncmp(argv[st], prefix, strlen(prefix)) != 0)
+            continue;
+
+        bool parsed = ParseSumMode(argv[st] + strlen(prefix), mode);
+        for (int next = st + 1; next <= argc; next++)
+            argv[next - 1] = argv[next];
+        argc--;
+        return parsed;
+    }
+    return true;
+}
+
+// Partial sums S(N) of the series are extrapolated at N = RichardsonStartTerms 2^k, k < RichardsonMaxLevels.
+const size_t RichardsonStartTerms = 8;
+const size_t RichardsonMaxLevels = 24;
+
+// Richardson extrapolation of partial sums at doubling N. The tail of the series expands
+// in powers of 1/N by the Euler-Maclaurin formula, column j of the table cancels the 1/N^j term.
+class RichardsonTable
+{
+private:
+    // Last row of the table.
+    std::vector<double> Row;
+    double Error = INFINITY;
+
+public:
+    size_t GetLevels() const
+    {
+        return Row.size();
+    }
+
+    // Extrapolated sum.
+    double GetValue() const
+    {
+        return Row.back();
+    }
+
+    // Difference of the last two diagonal values, INFINITY before the second sum.
+    double GetError() const
+    {
+        return Error;
+    }
+
+    // Adds S(2N) after S(N).
+    void Add(double partialSum)
+    {
+        std::vector<double> row = {partialSum};
+        for (size_t st = 1; st <= Row.size(); st++)
+        {
+            double factor = static_cast<double>((1ull << st) - 1);
+            row.push_back(row[st - 1] + (row[st - 1] - Row[st - 1]) / factor);
+        }
+
+        if (!Row.empty())
+            Error = std::abs(row.back() - Row.back());
+        Row = std::move(row);
+    }
+};
+
+struct AcceleratedSum
+{
+    double Value;
+    double Error;
+    // Terms summed.
+    size_t TermsCount;
+    size_t Levels;
+    bool Converged;
+};
+
+// Sums the series until the estimated error of the extrapolated sum is at most tolerance.
+// sumTerms(first, last) returns the sum of the terms [first, last), e.g. over processes and threads.
+template <typename SumTerms>
+AcceleratedSum AccelerateSum(double tolerance, SumTerms sumTerms)
+{
+    RichardsonTable table;
+    size_t termsCount = RichardsonStartTerms;
+    double sum = sumTerms(0, termsCount);
+    table.Add(sum);
+
+    while (table.GetError() > tolerance && table.GetLevels() < RichardsonMaxLevels)
+    {
+        sum += sumTerms(termsCount, 2 * termsCount);
+        termsCount *= 2;
+        table.Add(sum);
+    }
+
+    // Errors below the rounding of the sum are not resolved.
+    bool converged = table.GetError() <= tolerance && tolerance >= std::abs(table.GetValue()) * DBL_EPSILON;
+    return {table.GetValue(), table.GetError(), termsCount, table.GetLevels(), converged};
+}
\ No newline at end of file
@@ -4,6 +4,12 @@
 #include <numbers>
 #include <string>
 #include <sstream>
+#include <cstring>
+#include <omp.h>
+
+#include "Chudnovsky.h"
+#include "PiSeries.h"
+#include "common/metrics.h"
 
 static inline std::string DoubleToString(double number, std::streamsize prec = 36)
 {
@@ -17,29 +23,8 @@ static inline std::string DoubleToString(double number, std::streamsize prec = 3
     return pi_str.str();
 }
 
-int main(int argc, char* argv[])
+static void PrintPi(double pi)
 {
-    // Compute pi using formula: \pi / 4 = \sum_{n=0}^{+\infty} \frac{ 2 }{ (4n+1)(4n+3) }
-    auto progExecTimeStart = std::chrono::high_resolution_clock::now();
-    
-    if (argc != 2)
-    {
-        std::cout 
-            << "Enter count of terms in series as a first argument. Exponential (10^9 = 1e9) notation is possible." 
-            << std::endl;
-        return -1;
-    }
-
-    size_t operationsCount = static_cast<size_t>(std::stod(argv[1]));
-    double sum = 0;
-
-    for (size_t n = 0; n < operationsCount; n++)
-    {
-        sum += 2.0 / static_cast<double>((4*n + 1) * (4*n + 3));
-    }
-
-    double pi = sum * 4;
-
     std::cout 
         << "Computed pi  = "
         << DoubleToString(pi)
@@ -59,19 +44,205 @@ int main(int argc, char* argv[])
         << (pi - std::numbers::pi) / std::numbers::pi * 100.0
         << "%"
         << std::endl;
+}
+
+// Plain sums need about 1 / (2 tolerance) terms, their error is 4 / (8N).
+static void PrintAcceleratedSum(const AcceleratedSum& sum, double tolerance)
+{
+    // The difference of the diagonal values may be 0, the sum is not known better than its rounding.
+    double error = 4 * std::max(sum.Error, std::abs(sum.Value) * DBL_EPSILON);
+    std::cout
+        << std::scientific
+        << std::setprecision(2)
+        << "Estimated error = " << error << (sum.Converged ? "" : ", the tolerance is not reached in double") << "\n"
+        << "Terms = " << sum.TermsCount << ", extrapolation levels = " << sum.Levels << "\n";
+
+    if (sum.Converged)
+    {
+        double plainTermsCount = 1 / (2 * tolerance);
+        std::cout << "Plain sum terms = " << plainTermsCount << ", saved " << plainTermsCount / static_cast<double>(sum.TermsCount) << " times\n";
+    }
+    std::cout << std::flush;
+}
 
+// pi with error below the tolerance by Richardson extrapolation of the partial sums.
+static int ComputeAcceleratedPi(int argc, char* argv[], SumMode sumMode)
+{
+    auto progExecTimeStart = std::chrono::high_resolution_clock::now();
+
+    if (argc != 3 && argc != 4)
+    {
+        std::cout 
+            << "Enter tolerance as a second argument and count of threads as an optional third one." 
+            << std::endl;
+        return -1;
+    }
+
+    double tolerance = std::stod(argv[2]);
+    size_t threadsCount = argc == 4 ? std::stoul(argv[3]) : omp_get_max_threads();
+
+    AcceleratedSum sum = AccelerateSum(tolerance / 4, [threadsCount, sumMode](size_t first, size_t last)
+    {
+        return SumPiSeries(first, last, threadsCount, sumMode).Get();
+    });
+
+    PrintPi(4 * sum.Value);
+    std::cout
+        << std::endl;
+    PrintAcceleratedSum(sum, tolerance);
     std::cout
+        << "Summation = " << GetSumModeName(sumMode)
         << std::endl;
 
     auto progExecTimeStop = std::chrono::high_resolution_clock::now();
+    double progExecTime = std::chrono::duration<double>(progExecTimeStop - progExecTimeStart).count();
+    RunMetrics()
+        .Add("time", progExecTime)
+        .Add("threads", threadsCount)
+        .Add("terms", sum.TermsCount)
+        .Add("error", 4 * sum.Error)
+        .Save();
 
     std::cout
+        << std::endl
         << std::fixed
         << std::setprecision(6)
         << "Program execution time = "
-        << std::chrono::duration<double>(progExecTimeStop - progExecTimeStart).count()
+        << progExecTime
         << " seconds."
         << std::endl;
 
+    return sum.Converged ? 0 : -1;
+}
+
+static int ComputePiDigits(int argc, char* argv[])
+{
+    auto progExecTimeStart = std::chrono::high_resolution_clock::now();
+
+    if (argc != 3 && argc != 4)
+    {
+        std::cout 
+            << "Enter count of digits as a second argument and count of threads as an optional third one." 
+            << std::endl;
+        return -1;
+    }
+
+    size_t digits = static_cast<size_t>(std::stod(argv[2]));
+    size_t threadsCount = argc == 4 ? std::stoul(argv[3]) : omp_get_max_threads();
+    size_t termsCount = GetChudnovskyTermsCount(digits);
+
+    SplitTerms terms = SplitChudnovsky(1, termsCount, threadsCount);
+    auto splitTimeStop = std::chrono::high_resolution_clock::now();
+
+    std::string pi = GetPiDigits(terms, digits, threadsCount);
+    auto progExecTimeStop = std::chrono::high_resolution_clock::now();
+    double computeTime = std::chrono::duration<double>(progExecTimeStop - progExecTimeStart).count();
+
+    std::cout
+        << "Digits = " << digits << ", terms = " << termsCount << ", threads = " << threadsCount << "\n"
+        << std::endl;
+
+    bool checked = ReportPiDigits(pi, digits, computeTime);
+
+    RunMetrics()
+        .Add("time", computeTime)
+        .Add("split_time", std::chrono::duration<double>(splitTimeStop - progExecTimeStart).count())
+        .Add("threads", threadsCount)
+        .Add("digits", digits)
+        .Save();
+
+    std::cout
+        << std::endl
+        << std::fixed
+        << std::setprecision(6)
+        << "Binary splitting time  = "
+        << std::chrono::duration<double>(splitTimeStop - progExecTimeStart).count()
+        << " seconds.\n"
+        << "Program execution time = "
+        << computeTime
+        << " seconds."
+        << std::endl;
+
+    return checked ? 0 : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    SumMode sumMode = SumMode::Plain;
+    if (!TakeSumModeArgument(argc, argv, sumMode))
+    {
+        std::cout << "Unknown summation, enter sum=plain, sum=neumaier or sum=exact." << std::endl;
+        return -1;
+    }
+
+    // Digits of pi by the Chudnovsky series.
+    if (argc > 1 && strcmp(argv[1], "chudnovsky") == 0)
+        return ComputePiDigits(argc, argv);
+
+    // Series with convergence acceleration.
+    if (argc > 1 && strcmp(argv[1], "richardson") == 0)
+        return ComputeAcceleratedPi(argc, argv, sumMode);
+
+    // Compute pi using formula: \pi / 4 = \sum_{n=0}^{+\infty} \frac{ 2 }{ (4n+1)(4n+3) }
+    auto progExecTimeStart = std::chrono::high_resolution_clock::now();
+    
+    if (argc != 2 && argc != 3)
+    {
+        std::cout 
+            << "Enter count of terms in series as a first argument. Exponential (10^9 = 1e9) notation is possible.\n"
+            << "Enter count of threads as an optional second argument, all cores by default.\n"
+            << "Enter chudnovsky as the first argument to compute digits of pi,\n"
+            << "or richardson to sum the series up to a tolerance by Richardson extrapolation.\n"
+            << "Enter sum=plain, sum=neumaier or sum=exact to choose the summation of partial sums, plain by default.\n"
+            << "Exact sums are the same for any count of threads." 
+            << std::endl;
+        return -1;
+    }
+
+    size_t operationsCount = static_cast<size_t>(std::stod(argv[1]));
+    size_t threadsCount = argc == 3 ? std::stoul(argv[2]) : omp_get_max_threads();
+
+    auto computeTimeStart = std::chrono::high_resolution_clock::now();
+    double sum = SumPiSeries(0, operationsCount, threadsCount, sumMode).Get();
+    double computeTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - computeTimeStart).count();
+
+    double pi = sum * 4;
+
+    PrintPi(pi);
+
+    std::cout
+        << std::endl;
+
+    double termsPerSecond = static_cast<double>(operationsCount) / computeTime;
+    std::cout
+        << "Threads = " << threadsCount << ", summation = " << GetSumModeName(sumMode) << "\n"
+        << std::scientific
+        << std::setprecision(3)
+        << "Terms per second            = " << termsPerSecond << "\n"
+        << "Terms per second per thread = " << termsPerSecond / static_cast<double>(threadsCount)
+        << std::endl;
+
+    auto progExecTimeStop = std::chrono::high_resolution_clock::now();
+    double progExecTime = std::chrono::duration<double>(progExecTimeStop - progExecTimeStart).count();
+    RunMetrics metrics;
+    metrics
+        .Add("time", progExecTime)
+        .Add("compute_time", computeTime)
+        .Add("threads", threadsCount)
+        .Add("terms", operationsCount)
+        .Add("terms_per_second", termsPerSecond);
+    AddCounterMetrics(metrics);
+    metrics.Save();
+
+    std::cout
+        << std::fixed
+        << std::setprecision(6)
+        << "Program execution time = "
+        << progExecTime
+        << " seconds."
+        << std::endl;
+
+    PrintCounters("MAIN");
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,561 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "common/metrics.h"
+
+// Benchmark driver: runs a program for several counts of processes or threads with warm-ups
+// and repetitions, reads the metrics records the program saves, see common/metrics.h,
+// and reports medians with confidence intervals, speedup and efficiency.
+
+enum class Scaling
+{
+    // Same problem for all counts.
+    Strong,
+    // Problem grows with the count, e.g. by {*N} in the command.
+    Weak
+};
+
+struct BenchArgs
+{
+    std::vector<size_t> Counts;
+    size_t Runs;
+    size_t Warmup;
+    ::Scaling Scaling;
+    // Name of the metric of the records to compare, wall time of the run if the program saves none.
+    std::string Metric;
+    // Output files PREFIX.json, PREFIX.csv, PREFIX.samples.csv and PREFIX.log.
+    std::string Output;
+    std::vector<std::string> Command;
+};
+
+using Record = std::vector<std::pair<std::string, double>>;
+
+struct Sample
+{
+    double Value;
+    double WallTime;
+    // Value is the wall time, the program saved no record or no metric.
+    bool Wall;
+    std::string Record;
+};
+
+struct Summary
+{
+    size_t Count;
+    std::vector<Sample> Samples;
+    double Median;
+    double Mean;
+    double StdDev;
+    double Min;
+    double Max;
+    // 95% confidence interval of the median.
+    double MedianLow;
+    double MedianHigh;
+    // Relative to the first count, the bounds are ratios of the bounds of the medians.
+    double Speedup;
+    double SpeedupLow;
+    double SpeedupHigh;
+    double Efficiency;
+};
+
+static const char* GetScalingName(Scaling scaling)
+{
+    return scaling == Scaling::Strong ? "strong" : "weak";
+}
+
+static void PrintUsage()
+{
+    std::cout
+        << "Usage: bench [options] command args...\n"
+        << "{} in the command is replaced by the count, {*N} by N times the count, e.g.\n"
+        << "\tbench counts=1,2,4 mpirun -np {} ./ppi 1e9\n"
+        << "\tbench counts=1,2,4 scaling=weak ./int {} 1e-6 1 1e-13 {*1} 10000\n"
+        << "Options:\n"
+        << "\tcounts=C1,C2,... counts of processes or threads, the first one is the baseline;\n"
+        << "\truns=N measured runs per count, 10 by default;\n"
+        << "\twarmup=N runs per count before the measured ones, 1 by default;\n"
+        << "\tscaling=strong (default) or weak;\n"
+        << "\tmetric=NAME metric of the records to compare, time by default;\n"
+        << "\tout=PREFIX to save PREFIX.json, PREFIX.csv, PREFIX.samples.csv and PREFIX.log, perf/bench by default.\n"
+        << "Programs save their records to the file named by " << MetricsVariable << ", see common/metrics.h."
+        << std::endl;
+}
+
+static bool ParseCounts(const char* text, std::vector<size_t>& counts)
+{
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        char* end = nullptr;
+        unsigned long count = strtoul(item.c_str(), &end, 10);
+        if (item.empty() || *end || count == 0)
+            return false;
+        counts.push_back(count);
+    }
+    return !counts.empty();
+}
+
+static bool ParseBenchArgs(int argc, char* argv[], BenchArgs& args)
+{
+    args.Runs = 10;
+    args.Warmup = 1;
+    args.Scaling = Scaling::Strong;
+    args.Metric = "time";
+    args.Output = "perf/bench";
+
+    // Options up to the first other argument, the command.
+    int st = 1;
+    for (; st < argc; st++)
+    {
+        const char* value = strchr(argv[st], '=') ? strchr(argv[st], '=') + 1 : "";
+        if (strncmp(argv[st], "counts=", 7) == 0)
+        {
+            if (!ParseCounts(value, args.Counts))
+            {
+                std::cout << "Bad counts " << value << ", enter positive numbers separated by commas." << std::endl;
+                return false;
+            }
+        }
+        else if (strncmp(argv[st], "runs=", 5) == 0)
+            args.Runs = atoi(value);
+        else if (strncmp(argv[st], "warmup=", 7) == 0)
+            args.Warmup = atoi(value);
+        else if (strcmp(argv[st], "scaling=strong") == 0)
+            args.Scaling = Scaling::Strong;
+        else if (strcmp(argv[st], "scaling=weak") == 0)
+            args.Scaling = Scaling::Weak;
+        else if (strncmp(argv[st], "metric=", 7) == 0)
+            args.Metric = value;
+        else if (strncmp(argv[st], "out=", 4) == 0)
+            args.Output = value;
+        else
+            break;
+    }
+
+    args.Command.assign(argv + st, argv + argc);
+    if (args.Counts.empty() || args.Command.empty() || args.Runs == 0)
+    {
+        PrintUsage();
+        return false;
+    }
+    return true;
+}
+
+// Replaces {} and {*N} in arg.
+static std::string SubstituteCount(const std::string& arg, size_t count)
+{
+    std::string result;
+    size_t position = 0;
+    while (position < arg.size())
+    {
+        size_t open = arg.find('{', position);
+        size_t close = open == std::string::npos ? std::string::npos : arg.find('}', open);
+        if (close == std::string::npos)
+        {
+            result += arg.substr(position);
+            break;
+        }
+
+        result += arg.substr(position, open - position);
+        std::string inner = arg.substr(open + 1, close - open - 1);
+        if (inner.empty())
+            result += std::to_string(count);
+        else if (inner[0] == '*')
+        {
+            char value[32];
+            snprintf(value, sizeof(value), "%.15g", atof(inner.c_str() + 1) * static_cast<double>(count));
+            result += value;
+        }
+        else
+            result += arg.substr(open, close - open + 1);
+        position = close + 1;
+    }
+    return result;
+}
+
+// Flat JSON object of numbers and nulls, see RunMetrics::ToJson().
+static bool ParseRecord(const std::string& line, Record& record)
+{
+    const char* text = line.c_str();
+    while (*text == ' ')
+        text++;
+    if (*text++ != '{')
+        return false;
+
+    while (*text != '}')
+    {
+        if (*text == ',')
+            text++;
+
+        const char* nameEnd = *text == '"' ? strchr(text + 1, '"') : nullptr;
+        if (!nameEnd || nameEnd[1] != ':')
+            return false;
+
+        std::string name(text + 1, nameEnd);
+        text = nameEnd + 2;
+
+        double value = NAN;
+        if (strncmp(text, "null", 4) == 0)
+            text += 4;
+        else
+        {
+            char* end = nullptr;
+            value = strtod(text, &end);
+            if (end == text)
+                return false;
+            text = end;
+        }
+
+        record.emplace_back(name, value);
+        if (*text != ',' && *text != '}')
+            return false;
+    }
+    return true;
+}
+
+// Last record of the file.
+static std::string ReadLastRecord(const std::string& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::string last;
+    while (std::getline(file, line))
+    {
+        if (!line.empty())
+            last = line;
+    }
+    return last;
+}
+
+// Runs the command with its output appended to logPath. Returns false if it does not exit with 0.
+static bool RunCommand(const std::vector<std::string>& command, const std::string& logPath)
+{
+    std::vector<char*> argv;
+    for (const std::string& arg : command)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror("fork");
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        int log = open(logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (log >= 0)
+        {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            close(log);
+        }
+        execvp(argv[0], argv.data());
+        perror("execvp");
+        _exit(127);
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0)
+    {
+        perror("waitpid");
+        return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool RunSample(const BenchArgs& args, const std::vector<std::string>& command, Sample& sample)
+{
+    std::string metricsPath = args.Output + ".metrics";
+    remove(metricsPath.c_str());
+    setenv(MetricsVariable, metricsPath.c_str(), 1);
+
+    auto start = std::chrono::steady_clock::now();
+    bool succeeded = RunCommand(command, args.Output + ".log");
+    sample.WallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!succeeded)
+    {
+        std::cout << "The run failed, see " << args.Output << ".log." << std::endl;
+        return false;
+    }
+
+    sample.Record = ReadLastRecord(metricsPath);
+    remove(metricsPath.c_str());
+
+    Record record;
+    if (!sample.Record.empty() && !ParseRecord(sample.Record, record))
+    {
+        std::cout << "Bad metrics record " << sample.Record << "." << std::endl;
+        return false;
+    }
+
+    sample.Value = sample.WallTime;
+    sample.Wall = true;
+    for (const auto& [name, value] : record)
+    {
+        if (name == args.Metric && std::isfinite(value))
+        {
+            sample.Value = value;
+            sample.Wall = false;
+        }
+    }
+    return true;
+}
+
+// Distribution free 95% interval of the median by order statistics, sorted values.
+// Below 6 samples it is the whole range.
+static void GetMedianInterval(const std::vector<double>& sorted, double& low, double& high)
+{
+    double n = static_cast<double>(sorted.size());
+    double lowRank = std::floor(0.5 * n - 0.98 * std::sqrt(n));
+    double highRank = std::ceil(0.5 * n + 1 + 0.98 * std::sqrt(n));
+
+    low = sorted[static_cast<size_t>(std::max(lowRank, 1.0)) - 1];
+    high = sorted[static_cast<size_t>(std::min(highRank, n)) - 1];
+}
+
+static void Summarize(Summary& summary)
+{
+    std::vector<double> values;
+    for (const Sample& sample : summary.Samples)
+        values.push_back(sample.Value);
+    std::sort(values.begin(), values.end());
+
+    size_t n = values.size();
+    summary.Median = n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    summary.Min = values.front();
+    summary.Max = values.back();
+
+    double sum = 0;
+    for (double value : values)
+        sum += value;
+    summary.Mean = sum / static_cast<double>(n);
+
+    double squares = 0;
+    for (double value : values)
+        squares += (value - summary.Mean) * (value - summary.Mean);
+    summary.StdDev = n > 1 ? std::sqrt(squares / static_cast<double>(n - 1)) : 0;
+
+    GetMedianInterval(values, summary.MedianLow, summary.MedianHigh);
+}
+
+// Strong scaling: S = T(c0) / T(c), E = S c0 / c. Weak scaling: E = T(c0) / T(c), S = E c / c0,
+// c0 is the first count. Smaller metrics are better, e.g. times.
+static void ComputeScaling(const BenchArgs& args, std::vector<Summary>& summaries)
+{
+    const Summary& base = summaries.front();
+    for (Summary& summary : summaries)
+    {
+        double ratio = static_cast<double>(summary.Count) / static_cast<double>(base.Count);
+        double gain = args.Scaling == Scaling::Strong ? 1 : ratio;
+
+        summary.Speedup = gain * base.Median / summary.Median;
+        summary.SpeedupLow = gain * base.MedianLow / summary.MedianHigh;
+        summary.SpeedupHigh = gain * base.MedianHigh / summary.MedianLow;
+        summary.Efficiency = summary.Speedup / ratio;
+    }
+}
+
+static std::string QuoteJson(const std::string& text)
+{
+    std::string quoted = "\"";
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static std::string NumberJson(double value)
+{
+    if (!std::isfinite(value))
+        return "null";
+
+    char text[32];
+    snprintf(text, sizeof(text), "%.17g", value);
+    return text;
+}
+
+static bool SaveJson(const BenchArgs& args, const std::vector<Summary>& summaries)
+{
+    std::ofstream file(args.Output + ".json", std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "Can not open " << args.Output << ".json." << std::endl;
+        return false;
+    }
+
+    file << "{\n  \"command\": [";
+    for (size_t st = 0; st < args.Command.size(); st++)
+        file << (st ? ", " : "") << QuoteJson(args.Command[st]);
+    file << "],\n"
+         << "  \"scaling\": " << QuoteJson(GetScalingName(args.Scaling)) << ",\n"
+         << "  \"metric\": " << QuoteJson(args.Metric) << ",\n"
+         << "  \"runs\": " << args.Runs << ",\n"
+         << "  \"warmup\": " << args.Warmup << ",\n"
+         << "  \"baseline\": " << summaries.front().Count << ",\n"
+         << "  \"results\": [\n";
+
+    for (size_t st = 0; st < summaries.size(); st++)
+    {
+        const Summary& summary = summaries[st];
+        file << "    {\n"
+             << "      \"count\": " << summary.Count << ",\n"
+             << "      \"median\": " << NumberJson(summary.Median) << ",\n"
+             << "      \"median_low\": " << NumberJson(summary.MedianLow) << ",\n"
+             << "      \"median_high\": " << NumberJson(summary.MedianHigh) << ",\n"
+             << "      \"mean\": " << NumberJson(summary.Mean) << ",\n"
+             << "      \"stddev\": " << NumberJson(summary.StdDev) << ",\n"
+             << "      \"min\": " << NumberJson(summary.Min) << ",\n"
+             << "      \"max\": " << NumberJson(summary.Max) << ",\n"
+             << "      \"speedup\": " << NumberJson(summary.Speedup) << ",\n"
+             << "      \"speedup_low\": " << NumberJson(summary.SpeedupLow) << ",\n"
+             << "      \"speedup_high\": " << NumberJson(summary.SpeedupHigh) << ",\n"
+             << "      \"efficiency\": " << NumberJson(summary.Efficiency) << ",\n"
+             << "      \"samples\": [\n";
+
+        for (size_t run = 0; run < summary.Samples.size(); run++)
+        {
+            const Sample& sample = summary.Samples[run];
+            file << "        {\"value\": " << NumberJson(sample.Value)
+                 << ", \"wall\": " << NumberJson(sample.WallTime)
+                 << ", \"record\": " << (sample.Record.empty() ? "null" : sample.Record) << "}"
+                 << (run + 1 < summary.Samples.size() ? "," : "") << "\n";
+        }
+        file << "      ]\n    }" << (st + 1 < summaries.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}" << std::endl;
+    return file.good();
+}
+
+static bool SaveCsv(const BenchArgs& args, const std::vector<Summary>& summaries)
+{
+    std::ofstream file(args.Output + ".csv", std::ios::out | std::ios::trunc);
+    std::ofstream samples(args.Output + ".samples.csv", std::ios::out | std::ios::trunc);
+    if (!file.is_open() || !samples.is_open())
+    {
+        std::cout << "Can not open " << args.Output << ".csv or " << args.Output << ".samples.csv." << std::endl;
+        return false;
+    }
+
+    file << std::setprecision(17)
+         << "count,runs,median,median_low,median_high,mean,stddev,min,max,speedup,speedup_low,speedup_high,efficiency\n";
+    samples << std::setprecision(17)
+            << "count,run,value,wall\n";
+    for (const Summary& summary : summaries)
+    {
+        file << summary.Count << "," << summary.Samples.size() << ","
+             << summary.Median << "," << summary.MedianLow << "," << summary.MedianHigh << ","
+             << summary.Mean << "," << summary.StdDev << "," << summary.Min << "," << summary.Max << ","
+             << summary.Speedup << "," << summary.SpeedupLow << "," << summary.SpeedupHigh << ","
+             << summary.Efficiency << "\n";
+
+        for (size_t run = 0; run < summary.Samples.size(); run++)
+            samples << summary.Count << "," << run << "," << summary.Samples[run].Value << ","
+                    << summary.Samples[run].WallTime << "\n";
+    }
+    return file.good() && samples.good();
+}
+
+static void PrintSummaries(const BenchArgs& args, const std::vector<Summary>& summaries)
+{
+    std::cout << "\n"
+              << GetScalingName(args.Scaling) << " scaling of " << args.Metric
+              << ", 95% intervals of the medians, baseline count " << summaries.front().Count << ":\n"
+              << std::setw(8) << "count" << std::setw(14) << "median" << std::setw(28) << "interval"
+              << std::setw(12) << "speedup" << std::setw(22) << "interval" << std::setw(12) << "efficiency"
+              << "\n";
+
+    for (const Summary& summary : summaries)
+    {
+        std::stringstream interval;
+        interval << std::setprecision(5) << "[" << summary.MedianLow << ", " << summary.MedianHigh << "]";
+        std::stringstream speedupInterval;
+        speedupInterval << std::fixed << std::setprecision(2)
+                        << "[" << summary.SpeedupLow << ", " << summary.SpeedupHigh << "]";
+
+        std::cout << std::setw(8) << summary.Count
+                  << std::setw(14) << std::setprecision(5) << summary.Median
+                  << std::setw(28) << interval.str()
+                  << std::setw(12) << std::fixed << std::setprecision(2) << summary.Speedup
+                  << std::setw(22) << speedupInterval.str()
+                  << std::setw(11) << 100 * summary.Efficiency << "%"
+                  << std::defaultfloat << "\n";
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchArgs args = {};
+    if (!ParseBenchArgs(argc, argv, args))
+        return EXIT_FAILURE;
+
+    // Output directory of the default prefix.
+    size_t slash = args.Output.rfind('/');
+    if (slash != std::string::npos)
+        mkdir(args.Output.substr(0, slash).c_str(), 0755);
+    remove((args.Output + ".log").c_str());
+
+    std::vector<Summary> summaries;
+    for (size_t count : args.Counts)
+    {
+        std::vector<std::string> command;
+        for (const std::string& arg : args.Command)
+            command.push_back(SubstituteCount(arg, count));
+
+        std::cout << "Count " << count << ":";
+        for (const std::string& arg : command)
+            std::cout << " " << arg;
+        std::cout << std::endl;
+
+        Summary summary = {};
+        summary.Count = count;
+        for (size_t run = 0; run < args.Warmup + args.Runs; run++)
+        {
+            Sample sample = {};
+            if (!RunSample(args, command, sample))
+                return EXIT_FAILURE;
+
+            if (run < args.Warmup)
+                continue;
+
+            std::cout << "\t" << run - args.Warmup + 1 << ". " << std::setprecision(6) << sample.Value
+                      << (sample.Wall ? " (wall time, no metric " + args.Metric + ")" : "") << std::endl;
+            summary.Samples.push_back(std::move(sample));
+        }
+
+        Summarize(summary);
+        summaries.push_back(std::move(summary));
+    }
+
+    ComputeScaling(args, summaries);
+    PrintSummaries(args, summaries);
+
+    if (!SaveJson(args, summaries) || !SaveCsv(args, summaries))
+        return EXIT_FAILURE;
+
+    std::cout << "Results are saved to " << args.Output << ".json, " << args.Output << ".csv and "
+              << args.Output << ".samples.csv." << std::endl;
+    return 0;
+}
\ No newline at end of file
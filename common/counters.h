@@ -0,0 +1,308 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+// Hardware counters of named code regions by perf_event_open. They are on if the environment
+// variable PERF_COUNTERS is set to anything but 0, regions cost one branch otherwise.
+// Counters the kernel or the CPU do not give, e.g. in virtual machines, are reported as n/a.
+const char* const CountersVariable = "PERF_COUNTERS";
+
+enum class Counter
+{
+    // Time on the CPU, a software counter.
+    TaskClock,
+    Cycles,
+    Instructions,
+    CacheReferences,
+    // Last level cache misses, memory traffic is estimated as CacheMisses * CacheLineBytes.
+    CacheMisses
+};
+
+const size_t CountersCount = 5;
+
+// Lines of the last level cache, sysconf does not report it on all systems.
+const double CacheLineBytes = 64;
+
+inline bool CountersEnabled()
+{
+    static const bool enabled = []()
+    {
+        const char* value = getenv(CountersVariable);
+        return value && *value && strcmp(value, "0") != 0;
+    }();
+    return enabled;
+}
+
+// Counters of the calling thread, opened on its first region.
+class ThreadCounters
+{
+private:
+    int Fds[CountersCount];
+
+public:
+    ThreadCounters()
+    {
+        const std::pair<uint32_t, uint64_t> events[CountersCount] =
+        {
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}
+        };
+
+        for (size_t st = 0; st < CountersCount; st++)
+        {
+            perf_event_attr attr = {};
+            attr.size = sizeof(attr);
+            attr.type = events[st].first;
+            attr.config = events[st].second;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            // Counters are multiplexed if there are not enough of them, values are scaled by the running time.
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            Fds[st] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+    }
+
+    ~ThreadCounters()
+    {
+        for (int fd : Fds)
+        {
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator = (const ThreadCounters&) = delete;
+
+    static ThreadCounters& Get()
+    {
+        thread_local ThreadCounters counters;
+        return counters;
+    }
+
+    // NAN for counters that are not open.
+    void Read(double values[CountersCount]) const
+    {
+        for (size_t st = 0; st < CountersCount; st++)
+        {
+            uint64_t data[3] = {};
+            values[st] = NAN;
+            if (Fds[st] < 0 || read(Fds[st], data, sizeof(data)) != sizeof(data))
+                continue;
+
+            values[st] = data[2] ? static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]) : 0;
+        }
+    }
+};
+
+// Sums of the calls of a region over all threads.
+struct RegionTotals
+{
+    size_t Calls = 0;
+    // Wall time, summed over threads.
+    double Time = 0;
+    // Given by the regions, there are no portable counters of them.
+    double Flops = 0;
+    double Values[CountersCount] = {};
+    // Calls that read the counter.
+    size_t Counted[CountersCount] = {};
+
+    // Value of the counter, NAN if it is not read in all calls.
+    double Get(Counter counter) const
+    {
+        size_t index = static_cast<size_t>(counter);
+        return Counted[index] == Calls ? Values[index] : NAN;
+    }
+
+    double GetIpc() const
+    {
+        return Get(Counter::Instructions) / Get(Counter::Cycles);
+    }
+
+    double GetMemoryBytes() const
+    {
+        return Get(Counter::CacheMisses) * CacheLineBytes;
+    }
+
+    // Bytes per second of a thread.
+    double GetBandwidth() const
+    {
+        return GetMemoryBytes() / Time;
+    }
+
+    // Flops per byte of memory traffic, NAN without flops.
+    double GetIntensity() const
+    {
+        return Flops > 0 ? Flops / GetMemoryBytes() : NAN;
+    }
+};
+
+class CounterRegistry
+{
+private:
+    std::mutex Access;
+    std::vector<std::pair<std::string, RegionTotals>> Regions;
+
+public:
+    static CounterRegistry& Get()
+    {
+        static CounterRegistry registry;
+        return registry;
+    }
+
+    void Add(const char* name, const RegionTotals& call)
+    {
+        std::lock_guard<std::mutex> lock(Access);
+
+        RegionTotals* totals = nullptr;
+        for (auto& region : Regions)
+        {
+            if (region.first == name)
+                totals = &region.second;
+        }
+        if (!totals)
+            totals = &Regions.emplace_back(name, RegionTotals()).second;
+
+        totals->Calls += call.Calls;
+        totals->Time += call.Time;
+        totals->Flops += call.Flops;
+        for (size_t st = 0; st < CountersCount; st++)
+        {
+            totals->Values[st] += call.Values[st];
+            totals->Counted[st] += call.Counted[st];
+        }
+    }
+
+    std::vector<std::pair<std::string, RegionTotals>> GetRegions()
+    {
+        std::lock_guard<std::mutex> lock(Access);
+        return Regions;
+    }
+};
+
+// Counts the scope as a call of the region name. Regions of the same name are summed,
+// nested regions count their time in both.
+class CounterRegion
+{
+private:
+    const char* Name = nullptr;
+    double Flops = 0;
+    std::chrono::steady_clock::time_point Start;
+    double StartValues[CountersCount] = {};
+
+public:
+    explicit CounterRegion(const char* name, double flops = 0)
+    {
+        if (!CountersEnabled())
+            return;
+
+        Name = name;
+        Flops = flops;
+        ThreadCounters::Get().Read(StartValues);
+        Start = std::chrono::steady_clock::now();
+    }
+
+    ~CounterRegion()
+    {
+        if (!Name)
+            return;
+
+        double values[CountersCount];
+        ThreadCounters::Get().Read(values);
+
+        RegionTotals call;
+        call.Calls = 1;
+        call.Time = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        call.Flops = Flops;
+        for (size_t st = 0; st < CountersCount; st++)
+        {
+            if (std::isfinite(values[st]) && std::isfinite(StartValues[st]))
+            {
+                call.Values[st] = values[st] - StartValues[st];
+                call.Counted[st] = 1;
+            }
+        }
+        CounterRegistry::Get().Add(Name, call);
+    }
+
+    CounterRegion(const CounterRegion&) = delete;
+    CounterRegion& operator = (const CounterRegion&) = delete;
+
+    // Flops known only at the end of the region.
+    void AddFlops(double flops)
+    {
+        Flops += flops;
+    }
+};
+
+inline std::string FormatCounter(double value, double scale = 1, int precision = 3)
+{
+    if (!std::isfinite(value))
+        return "n/a";
+
+    std::stringstream text;
+    text.precision(precision);
+    text << value / scale;
+    return text.str();
+}
+
+// Prints the regions, label is e.g. the rank. Bandwidth and GFLOP/s are per thread.
+inline void PrintCounters(const std::string& label)
+{
+    if (!CountersEnabled())
+        return;
+
+    std::stringstream text;
+    for (const auto& [name, totals] : CounterRegistry::Get().GetRegions())
+    {
+        text << label << " " << name << ":\n"
+             << "\tCalls          = " << totals.Calls << ", time = " << FormatCounter(totals.Time) << " s"
+             << ", CPU time = " << FormatCounter(totals.Get(Counter::TaskClock), 1e9) << " s\n"
+             << "\tCycles         = " << FormatCounter(totals.Get(Counter::Cycles))
+             << ", instructions = " << FormatCounter(totals.Get(Counter::Instructions))
+             << ", IPC = " << FormatCounter(totals.GetIpc()) << "\n"
+             << "\tLLC misses     = " << FormatCounter(totals.Get(Counter::CacheMisses))
+             << " of " << FormatCounter(totals.Get(Counter::CacheReferences)) << " references\n"
+             << "\tMemory         = " << FormatCounter(totals.GetMemoryBytes(), 1e9) << " GB, "
+             << FormatCounter(totals.GetBandwidth(), 1e9) << " GB/s\n"
+             << "\tFlops          = " << FormatCounter(totals.Flops > 0 ? totals.Flops : NAN, 1e9) << " G, "
+             << FormatCounter(totals.Flops > 0 ? totals.Flops / totals.Time : NAN, 1e9) << " GFLOP/s"
+             << ", intensity = " << FormatCounter(totals.GetIntensity()) << " flop/B\n";
+    }
+    std::cout << text.str() << std::flush;
+}
+
+// Adds REGION.time, .ipc, .bandwidth and .intensity of the regions to the record of the run.
+inline void AddCounterMetrics(RunMetrics& metrics)
+{
+    if (!CountersEnabled())
+        return;
+
+    for (const auto& [name, totals] : CounterRegistry::Get().GetRegions())
+    {
+        metrics
+            .Add(name + ".time", totals.Time)
+            .Add(name + ".ipc", totals.GetIpc())
+            .Add(name + ".bandwidth", totals.GetBandwidth())
+            .Add(name + ".intensity", totals.GetIntensity());
+    }
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Environment variable with the metrics file of a run, it is set by the benchmark driver, see bench.cpp.
+const char* const MetricsVariable = "BENCH_METRICS";
+
+// Named values of a run, e.g. "time" in seconds. Saved as one line of flat JSON,
+// so the driver does not scrape the output of the programs.
+class RunMetrics
+{
+private:
+    std::vector<std::pair<std::string, double>> Values;
+
+public:
+    RunMetrics& Add(const std::string& name, double value)
+    {
+        Values.emplace_back(name, value);
+        return *this;
+    }
+
+    std::string ToJson() const
+    {
+        std::string json = "{";
+        for (size_t st = 0; st < Values.size(); st++)
+        {
+            char value[32] = "null";
+            if (std::isfinite(Values[st].second))
+                snprintf(value, sizeof(value), "%.17g", Values[st].second);
+
+            json += (st ? ",\"" : "\"") + Values[st].first + "\":" + value;
+        }
+        return json + "}";
+    }
+
+    // Appends the record to the file of MetricsVariable if it is set. One process of a run saves it.
+    bool Save() const
+    {
+        const char* path = getenv(MetricsVariable);
+        if (!path || !*path)
+            return true;
+
+        FILE* file = fopen(path, "a");
+        if (!file)
+        {
+            std::cout << "Can not open metrics file " << path << "." << std::endl;
+            return false;
+        }
+
+        bool written = fprintf(file, "%s\n", ToJson().c_str()) > 0;
+        return fclose(file) == 0 && written;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstring>
+#include <mpi.h>
+
+#include "reduction.h"
+
+// Collectives of SumAccumulator, one MPI_Reduce or MPI_Allreduce each. Plain and Neumaier sums
+// go through non-commutative operations, so MPI combines them in rank order. Exact sums are
+// added limb by limb as integers, which is exact in any order.
+struct SumCollectives
+{
+    MPI_Datatype NeumaierType;
+    MPI_Datatype ExactType;
+    MPI_Op PlainOp;
+    MPI_Op NeumaierOp;
+    MPI_Op ExactOp;
+};
+
+// in is the sum of the lower ranks.
+inline void MergePlainSums(void* in, void* inout, int* len, MPI_Datatype*)
+{
+    const double* left = static_cast<const double*>(in);
+    double* right = static_cast<double*>(inout);
+    for (int st = 0; st < *len; st++)
+        right[st] = left[st] + right[st];
+}
+
+inline void MergeNeumaierSums(void* in, void* inout, int* len, MPI_Datatype*)
+{
+    const NeumaierSum* left = static_cast<const NeumaierSum*>(in);
+    NeumaierSum* right = static_cast<NeumaierSum*>(inout);
+    for (int st = 0; st < *len; st++)
+    {
+        NeumaierSum sum = left[st];
+        sum.Merge(right[st]);
+        right[st] = sum;
+    }
+}
+
+// Normalized limbs, then the bits of NonFinite.
+const int ExactSumWords = ExactSum::LimbsCount + 1;
+
+inline void MergeExactSums(void* in, void* inout, int* len, MPI_Datatype*)
+{
+    const int64_t* left = static_cast<const int64_t*>(in);
+    int64_t* right = static_cast<int64_t*>(inout);
+    for (int st = 0; st < *len; st++, left += ExactSumWords, right += ExactSumWords)
+    {
+        for (size_t limb = 0; limb < ExactSum::LimbsCount; limb++)
+            right[limb] += left[limb];
+
+        double leftNonFinite = 0;
+        double rightNonFinite = 0;
+        memcpy(&leftNonFinite, left + ExactSum::LimbsCount, sizeof(double));
+        memcpy(&rightNonFinite, right + ExactSum::LimbsCount, sizeof(double));
+        rightNonFinite += leftNonFinite;
+        memcpy(right + ExactSum::LimbsCount, &rightNonFinite, sizeof(double));
+    }
+}
+
+// Created on the first use, after MPI_Init.
+inline const SumCollectives& GetSumCollectives()
+{
+    static const SumCollectives collectives = []()
+    {
+        SumCollectives created = {};
+        MPI_Type_contiguous(2, MPI_DOUBLE, &created.NeumaierType);
+        MPI_Type_commit(&created.NeumaierType);
+        MPI_Type_contiguous(ExactSumWords, MPI_INT64_T, &created.ExactType);
+        MPI_Type_commit(&created.ExactType);
+
+        MPI_Op_create(MergePlainSums, 0, &created.PlainOp);
+        MPI_Op_create(MergeNeumaierSums, 0, &created.NeumaierOp);
+        MPI_Op_create(MergeExactSums, 1, &created.ExactOp);
+        return created;
+    }();
+    return collectives;
+}
+
+// Sums of all processes to root, or to all processes if root < 0. Returns the MPI error code.
+inline int CollectSum(SumAccumulator& sum, int root, MPI_Comm comm)
+{
+    const SumCollectives& collectives = GetSumCollectives();
+    auto collect = [root, comm](const void* in, void* out, MPI_Datatype type, MPI_Op op)
+    {
+        return root < 0 ? MPI_Allreduce(in, out, 1, type, op, comm) : MPI_Reduce(in, out, 1, type, op, root, comm);
+    };
+
+    SumAccumulator result(sum.GetMode());
+    int error = MPI_SUCCESS;
+    switch (sum.GetMode())
+    {
+        case SumMode::Plain:
+        {
+            double in = sum.Get();
+            double out = 0;
+            error = collect(&in, &out, MPI_DOUBLE, collectives.PlainOp);
+            result += out;
+            break;
+        }
+
+        case SumMode::Neumaier:
+            error = collect(&sum.GetCompensated(), &result.GetCompensated(), collectives.NeumaierType, collectives.NeumaierOp);
+            break;
+
+        case SumMode::Exact:
+        {
+            ExactSum& exact = sum.GetExact();
+            exact.Normalize();
+
+            int64_t in[ExactSumWords];
+            int64_t out[ExactSumWords] = {};
+            memcpy(in, exact.Limbs, sizeof(exact.Limbs));
+            memcpy(in + ExactSum::LimbsCount, &exact.NonFinite, sizeof(double));
+            error = collect(in, out, collectives.ExactType, collectives.ExactOp);
+
+            ExactSum& collected = result.GetExact();
+            memcpy(collected.Limbs, out, sizeof(collected.Limbs));
+            memcpy(&collected.NonFinite, out + ExactSum::LimbsCount, sizeof(double));
+            collected.Normalize();
+            break;
+        }
+    }
+
+    sum = result;
+    return error;
+}
\ No newline at end of file
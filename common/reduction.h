@@ -0,0 +1,287 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Sums of partial results of threads and processes. Partial sums are combined in a fixed binary
+// tree by index, so a result depends only on the partial sums, not on the order they are ready in.
+enum class SumMode
+{
+    // Double additions.
+    Plain,
+    // Neumaier compensated summation, the error does not grow with the number of terms.
+    Neumaier,
+    // Exact fixed point sum, the result does not depend on the order of the terms at all,
+    // e.g. on the tasks done by every thread.
+    Exact
+};
+
+inline const char* GetSumModeName(SumMode mode)
+{
+    switch (mode)
+    {
+        case SumMode::Plain:
+            return "plain";
+        case SumMode::Neumaier:
+            return "neumaier";
+        case SumMode::Exact:
+            return "exact";
+    }
+    return "";
+}
+
+// plain, neumaier or exact. Returns false on other names.
+inline bool ParseSumMode(const char* name, SumMode& mode)
+{
+    for (SumMode known : {SumMode::Plain, SumMode::Neumaier, SumMode::Exact})
+    {
+        if (strcmp(name, GetSumModeName(known)) == 0)
+        {
+            mode = known;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct NeumaierSum
+{
+    double Sum = 0;
+    double Compensation = 0;
+
+    void Add(double x)
+    {
+        double sum = Sum + x;
+        if (std::abs(Sum) >= std::abs(x))
+            Compensation += (Sum - sum) + x;
+        else
+            Compensation += (x - sum) + Sum;
+        Sum = sum;
+    }
+
+    NeumaierSum& operator += (double x)
+    {
+        Add(x);
+        return *this;
+    }
+
+    void Merge(const NeumaierSum& sum)
+    {
+        Add(sum.Sum);
+        Compensation += sum.Compensation;
+    }
+
+    double Get() const
+    {
+        return Sum + Compensation;
+    }
+};
+
+// Fixed point sum over the whole range of double: bit i of the value has weight 2^(i - 1074)
+// and is kept in limb i / 32. Limbs are int64, the carries are propagated every 2^30 additions.
+struct ExactSum
+{
+    // Bits of finite doubles and 64 bits for the growth of the sum.
+    static const size_t LimbsCount = (2098 + 64) / 32 + 3;
+    static const uint32_t NormalizeInterval = 1u << 30;
+
+    int64_t Limbs[LimbsCount] = {};
+    uint32_t Pending = 0;
+    // Sum of infinities and NaNs.
+    double NonFinite = 0;
+
+    void Add(double x)
+    {
+        uint64_t bits = 0;
+        memcpy(&bits, &x, sizeof(bits));
+
+        uint64_t exponent = (bits >> 52) & 0x7FF;
+        uint64_t mantissa = bits & ((1ull << 52) - 1);
+        if (exponent == 0x7FF)
+        {
+            NonFinite += x;
+            return;
+        }
+
+        // Subnormals have the weight of exponent 1 without the implicit bit.
+        size_t shift = 0;
+        if (exponent != 0)
+        {
+            mantissa |= 1ull << 52;
+            shift = exponent - 1;
+        }
+
+        unsigned __int128 value = static_cast<unsigned __int128>(mantissa) << (shift % 32);
+        int64_t* limbs = Limbs + shift / 32;
+        int64_t sign = bits >> 63 ? -1 : 1;
+        limbs[0] += sign * static_cast<int64_t>(static_cast<uint32_t>(value));
+        limbs[1] += sign * static_cast<int64_t>(static_cast<uint32_t>(value >> 32));
+        limbs[2] += sign * static_cast<int64_t>(value >> 64);
+
+        if (++Pending == NormalizeInterval)
+            Normalize();
+    }
+
+    ExactSum& operator += (double x)
+    {
+        Add(x);
+        return *this;
+    }
+
+    // Limbs below the top one to [0, 2^32), the top one keeps the sign.
+    void Normalize()
+    {
+        int64_t carry = 0;
+        for (size_t st = 0; st < LimbsCount - 1; st++)
+        {
+            int64_t limb = Limbs[st] + carry;
+            carry = limb >> 32;
+            Limbs[st] = limb - carry * (1ll << 32);
+        }
+        Limbs[LimbsCount - 1] += carry;
+        Pending = 0;
+    }
+
+    void Merge(const ExactSum& sum)
+    {
+        ExactSum other = sum;
+        other.Normalize();
+        Normalize();
+
+        for (size_t st = 0; st < LimbsCount; st++)
+            Limbs[st] += other.Limbs[st];
+        NonFinite += other.NonFinite;
+        Pending = 2;
+    }
+
+    // The sum rounded to the nearest double.
+    double Get() const
+    {
+        if (NonFinite != 0)
+            return NonFinite;
+
+        ExactSum sum = *this;
+        sum.Normalize();
+
+        bool negative = sum.Limbs[LimbsCount - 1] < 0;
+        if (negative)
+        {
+            for (int64_t& limb : sum.Limbs)
+                limb = -limb;
+            sum.Normalize();
+        }
+
+        size_t top = LimbsCount;
+        while (top > 0 && sum.Limbs[top - 1] == 0)
+            top--;
+        if (top == 0)
+            return 0;
+
+        // 65 to 96 significant bits of the top limbs, lower ones only decide ties.
+        size_t low = top >= 3 ? top - 3 : 0;
+        unsigned __int128 value = 0;
+        for (size_t st = top; st-- > low; )
+            value = (value << 32) | static_cast<uint64_t>(sum.Limbs[st]);
+        for (size_t st = 0; st < low; st++)
+        {
+            if (sum.Limbs[st] != 0)
+            {
+                value |= 1;
+                break;
+            }
+        }
+
+        double result = std::ldexp(static_cast<double>(value), static_cast<int>(32 * low) - 1074);
+        return negative ? -result : result;
+    }
+};
+
+// Sum in the given mode.
+class SumAccumulator
+{
+private:
+    SumMode Mode = SumMode::Plain;
+    // Plain sums are kept in Compensated.Sum.
+    NeumaierSum Compensated;
+    ExactSum Exact;
+
+public:
+    SumAccumulator() = default;
+
+    explicit SumAccumulator(SumMode mode) :
+        Mode(mode)
+    {
+    }
+
+    SumMode GetMode() const
+    {
+        return Mode;
+    }
+
+    SumAccumulator& operator += (double x)
+    {
+        switch (Mode)
+        {
+            case SumMode::Plain:
+                Compensated.Sum += x;
+                break;
+            case SumMode::Neumaier:
+                Compensated.Add(x);
+                break;
+            case SumMode::Exact:
+                Exact.Add(x);
+                break;
+        }
+        return *this;
+    }
+
+    void Merge(const SumAccumulator& sum)
+    {
+        switch (Mode)
+        {
+            case SumMode::Plain:
+                Compensated.Sum += sum.Compensated.Sum;
+                break;
+            case SumMode::Neumaier:
+                Compensated.Merge(sum.Compensated);
+                break;
+            case SumMode::Exact:
+                Exact.Merge(sum.Exact);
+                break;
+        }
+    }
+
+    double Get() const
+    {
+        return Mode == SumMode::Exact ? Exact.Get() : Compensated.Get();
+    }
+
+    // State of the mode, e.g. for the collectives, see mpi_reduction.h.
+    NeumaierSum& GetCompensated()
+    {
+        return Compensated;
+    }
+
+    ExactSum& GetExact()
+    {
+        return Exact;
+    }
+};
+
+// Merges sums[0] with sums[1], sums[2] with sums[3] and so on, then the pairs in the same way.
+// All sums must have the same mode.
+inline SumAccumulator ReduceTree(std::vector<SumAccumulator> sums)
+{
+    if (sums.empty())
+        return SumAccumulator();
+
+    for (size_t step = 1; step < sums.size(); step *= 2)
+    {
+        for (size_t st = 0; st + step < sums.size(); st += 2 * step)
+            sums[st].Merge(sums[st + step]);
+    }
+    return sums[0];
+}
\ No newline at end of file
@@ -0,0 +1,455 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#include "../common/reduction.h"
+#include "cubature.h"
+#include "scheduler.h"
+
+// Relative difference of fourth differences of F taken as equal, the widest axis of them is split.
+const double AxisDifferenceTolerance = 1e-10;
+
+// Genz-Malik rule of degree 7 on [-1, 1]^dims, A. C. Genz, A. A. Malik, "An adaptive algorithm
+// for numerical integration over an n-dimensional rectangular region", 1980.
+struct GenzMalikRule
+{
+    size_t Dims;
+    size_t PointsCount;
+    // The center, then +-Lambda2 and +-Lambda4 on axis i at 1 + 4 i, then +-Lambda4 on pairs
+    // of axes and +-Lambda5 at the corners.
+    double Points[MaxCubaturePoints][MaxCubatureDims];
+    double Weights[MaxCubaturePoints];
+};
+
+static const double Lambda2 = std::sqrt(9.0 / 70);
+static const double Lambda4 = std::sqrt(9.0 / 10);
+static const double Lambda5 = std::sqrt(9.0 / 19);
+
+static GenzMalikRule CreateGenzMalikRule(size_t dims)
+{
+    GenzMalikRule rule = {};
+    rule.Dims = dims;
+
+    double n = dims;
+    double weight1 = (12824 - 9120 * n + 400 * n * n) / 19683;
+    double weight2 = 980.0 / 6561;
+    double weight3 = (1820 - 400 * n) / 19683;
+    double weight4 = 200.0 / 19683;
+    double weight5 = 6859.0 / 19683 / (1 << dims);
+
+    auto add = [&rule](double weight) -> double*
+    {
+        rule.Weights[rule.PointsCount] = weight;
+        return rule.Points[rule.PointsCount++];
+    };
+
+    add(weight1);
+
+    for (size_t axis = 0; axis < dims; axis++)
+    {
+        add(weight2)[axis] =  Lambda2;
+        add(weight2)[axis] = -Lambda2;
+        add(weight3)[axis] =  Lambda4;
+        add(weight3)[axis] = -Lambda4;
+    }
+
+    for (size_t axis1 = 0; axis1 < dims; axis1++)
+    {
+        for (size_t axis2 = axis1 + 1; axis2 < dims; axis2++)
+        {
+            for (size_t signs = 0; signs < 4; signs++)
+            {
+                double* point = add(weight4);
+                point[axis1] = signs & 1 ? -Lambda4 : Lambda4;
+                point[axis2] = signs & 2 ? -Lambda4 : Lambda4;
+            }
+        }
+    }
+
+    for (size_t corner = 0; corner < static_cast<size_t>(1) << dims; corner++)
+    {
+        double* point = add(weight5);
+        for (size_t axis = 0; axis < dims; axis++)
+            point[axis] = (corner >> axis) & 1 ? -Lambda5 : Lambda5;
+    }
+
+    assert(rule.PointsCount == GetGenzMalikPoints(dims));
+    return rule;
+}
+
+// Evaluates the rule on count <= 2 * TasksBatchSize boxes by one call of function,
+// sets Int and Axis of the boxes.
+static void EvaluateBoxes(const GenzMalikRule& rule, const MultiIntegrand& function, Box* boxes, size_t count)
+{
+    assert(count <= 2 * TasksBatchSize);
+
+    const size_t pointsCount = rule.PointsCount;
+
+    double x[MaxCubatureDims][2 * TasksBatchSize * MaxCubaturePoints];
+    double f[2 * TasksBatchSize * MaxCubaturePoints];
+
+    for (size_t st = 0; st < count; st++)
+    {
+        const Box& box = boxes[st];
+        for (size_t point = 0; point < pointsCount; point++)
+        {
+            for (size_t axis = 0; axis < rule.Dims; axis++)
+                x[axis][st * pointsCount + point] = box.Center[axis] + box.HalfWidth[axis] * rule.Points[point][axis];
+        }
+    }
+
+    const double* coordinates[MaxCubatureDims] = {};
+    for (size_t axis = 0; axis < rule.Dims; axis++)
+        coordinates[axis] = x[axis];
+
+    function(coordinates, f, count * pointsCount);
+
+    // Fourth differences cancel the second derivative: Lambda2^2 / Lambda4^2.
+    const double ratio = 1.0 / 7;
+
+    for (size_t st = 0; st < count; st++)
+    {
+        Box& box = boxes[st];
+        const double* fBox = f + st * pointsCount;
+
+        double sum = 0;
+        for (size_t point = 0; point < pointsCount; point++)
+            sum += rule.Weights[point] * fBox[point];
+
+        double volume = 1;
+        for (size_t axis = 0; axis < rule.Dims; axis++)
+            volume *= 2 * box.HalfWidth[axis];
+        box.Int = volume * sum;
+
+        double f0 = fBox[0];
+        double maxDifference = -1;
+        box.Axis = 0;
+        for (size_t axis = 0; axis < rule.Dims; axis++)
+        {
+            const double* fAxis = fBox + 1 + 4 * axis;
+            double difference = std::abs(fAxis[0] + fAxis[1] - 2 * f0 - ratio * (fAxis[2] + fAxis[3] - 2 * f0));
+
+            // Equal differences, e.g. of separable integrands, split the widest axis.
+            if (difference > maxDifference * (1 + AxisDifferenceTolerance) ||
+                (difference >= maxDifference * (1 - AxisDifferenceTolerance) && box.HalfWidth[axis] > box.HalfWidth[box.Axis]))
+            {
+                maxDifference = std::max(maxDifference, difference);
+                box.Axis = axis;
+            }
+        }
+    }
+}
+
+struct CConfig : SchedulerPool<Box>
+{
+    size_t TaskToDoPacketSize;
+    double Eps;
+    GenzMalikRule Rule;
+    MultiIntegrand Function;
+
+    std::atomic<size_t> ProcNumber;
+
+    // Private stacks of the threads at start.
+    std::vector<VectorStack<Box>> StartBoxes;
+
+    // Results of the threads by thread index, they are merged in a tree.
+    std::vector<SumAccumulator> ThreadResults;
+    size_t TotalTasksDone;
+    size_t TotalEvaluations;
+
+    sem_t ConfAccess;
+};
+
+struct CThread : SchedulerThread<VectorStack<Box>, Box>
+{
+    double Result;
+};
+
+// Splits up to TasksBatchSize boxes from the top of the stack, evaluates all halves in one
+// vectorized call and then accepts or pushes them.
+static void DoTasks(CThread& thread, CConfig& conf)
+{
+    Box batch[TasksBatchSize];
+    Box halves[2 * TasksBatchSize];
+
+    size_t tasksDone = 0;
+    while (tasksDone < conf.TaskToDoPacketSize && thread.Tasks.Size() > 0)
+    {
+        size_t count = thread.Tasks.Pop(batch, TasksBatchSize);
+
+        size_t halvesCount = 0;
+        bool split[TasksBatchSize] = {};
+        for (size_t st = 0; st < count; st++)
+        {
+            const Box& box = batch[st];
+            size_t axis = box.Axis;
+            double halfWidth = box.HalfWidth[axis] / 2;
+            double center1 = box.Center[axis] - halfWidth;
+            double center2 = box.Center[axis] + halfWidth;
+
+            // Too narrow to split.
+            if (center1 == box.Center[axis] || center2 == box.Center[axis])
+            {
+                thread.Result += box.Int;
+                continue;
+            }
+
+            Box& half1 = halves[halvesCount++];
+            Box& half2 = halves[halvesCount++];
+            half1 = box;
+            half2 = box;
+            half1.HalfWidth[axis] = halfWidth;
+            half2.HalfWidth[axis] = halfWidth;
+            half1.Center[axis] = center1;
+            half2.Center[axis] = center2;
+            split[st] = true;
+        }
+
+        EvaluateBoxes(conf.Rule, conf.Function, halves, halvesCount);
+        thread.Profile.Evaluations += halvesCount * conf.Rule.PointsCount;
+
+        const Box* half = halves;
+        for (size_t st = 0; st < count; st++)
+        {
+            if (!split[st])
+                continue;
+
+            double Ih = batch[st].Int;
+            double Ih2 = half[0].Int + half[1].Int;
+            tasksDone++;
+
+            if (std::abs(Ih - Ih2) < conf.Eps)
+                thread.Result += Ih2;
+            else
+            {
+                thread.Tasks.Push(half[0]);
+                thread.Tasks.Push(half[1]);
+            }
+            half += 2;
+        }
+    }
+
+    thread.Profile.TasksDone += tasksDone;
+}
+
+// Boxes go through the shared deques one by one.
+struct CubaturePolicy
+{
+    using Item = Box;
+    using Thread = CThread;
+    using Pool = CConfig;
+
+    static size_t GetTasksCount(const CThread& thread)
+    {
+        return thread.Tasks.Size();
+    }
+
+    static size_t GetTasksCount(const Box&)
+    {
+        return 1;
+    }
+
+    static bool TakeOldest(CThread& thread, Box& box)
+    {
+        return thread.Tasks.TakeOldest(box);
+    }
+
+    static void PushItem(CThread& thread, const Box& box)
+    {
+        thread.Tasks.Push(box);
+    }
+
+    static void DoTasks(CThread& thread, CConfig& conf)
+    {
+        ::DoTasks(thread, conf);
+    }
+
+    static bool HasNewTasks(const CConfig&)
+    {
+        return false;
+    }
+
+    static bool TakeNewTasks(CThread&, CConfig&)
+    {
+        return false;
+    }
+};
+
+static void* ThreadFunction(void* args)
+{
+    assert(args);
+
+    CConfig* const conf = static_cast<CConfig*>(args);
+    CThread thread = {};
+
+    thread.ProcNumber = conf->ProcNumber++;
+    thread.Profile.Thread = thread.ProcNumber;
+    thread.Tasks = std::move(conf->StartBoxes[thread.ProcNumber]);
+    thread.SharedTasks = &conf->SharedTasks[thread.ProcNumber];
+    thread.RandomState = 0x9E3779B97F4A7C15ull * (thread.ProcNumber + 1);
+
+    // Every thread starts active with its share of the start boxes.
+    Scheduler<CubaturePolicy>::Run(thread, *conf);
+
+    sem_wait(&conf->ConfAccess);
+
+    std::cout << "THREAD[" << thread.ProcNumber << "]:\n"
+              << "\tTasks done      = " << thread.Profile.TasksDone << "\n"
+              << "\tEvaluations     = " << thread.Profile.Evaluations << "\n"
+              << "\tTasks shared    = " << thread.Profile.TasksShared << "\n"
+              << "\tTasks stolen    = " << thread.Profile.TasksStolen << "\n"
+              << "\tMax tasks count = " << thread.Profile.MaxTasksCount << "\n"
+              << std::endl;
+
+    conf->ThreadResults[thread.ProcNumber] += thread.Result;
+    conf->TotalTasksDone += thread.Profile.TasksDone;
+    conf->TotalEvaluations += thread.Profile.Evaluations;
+
+    sem_post(&conf->ConfAccess);
+
+    return 0;
+}
+
+// Equal boxes, StartBoxesCount along every axis, dealt to the threads in contiguous shares.
+static void CreateStartBoxes(CConfig& conf, const CubatureArgs& args)
+{
+    size_t boxesCount = 1;
+    for (size_t axis = 0; axis < args.Dims; axis++)
+        boxesCount *= args.StartBoxesCount;
+
+    Box boxes[2 * TasksBatchSize];
+    for (size_t first = 0; first < boxesCount; first += 2 * TasksBatchSize)
+    {
+        size_t count = std::min(2 * TasksBatchSize, boxesCount - first);
+        for (size_t st = 0; st < count; st++)
+        {
+            Box& box = boxes[st];
+            box = {};
+
+            size_t index = first + st;
+            for (size_t axis = 0; axis < args.Dims; axis++)
+            {
+                size_t position = index % args.StartBoxesCount;
+                index /= args.StartBoxesCount;
+
+                double width = (args.Upper[axis] - args.Lower[axis]) / static_cast<double>(args.StartBoxesCount);
+                box.HalfWidth[axis] = width / 2;
+                box.Center[axis] = args.Lower[axis] + (position + 0.5) * width;
+            }
+        }
+
+        EvaluateBoxes(conf.Rule, conf.Function, boxes, count);
+        conf.TotalEvaluations += count * conf.Rule.PointsCount;
+
+        for (size_t st = 0; st < count; st++)
+            conf.StartBoxes[(first + st) * conf.ThreadsNumber / boxesCount].Push(boxes[st]);
+    }
+}
+
+bool ParseCubatureArgs(int argc, char* argv[], int first, CubatureArgs& args)
+{
+    int count = argc - first;
+    if (count < 9 || count > 5 + 2 * static_cast<int>(MaxCubatureDims) || count % 2 == 0)
+    {
+        std::cout
+            << "Enter as the first argument number of threads.\n"
+            << "As the second argument enter epsilon.\n"
+            << "As the third argument enter start number of boxes along every axis.\n"
+            << "As the fourth argument enter tasks packet size.\n"
+            << "As the fifth argument enter f=EXPRESSION of x, y, z and w, e.g. f=\"exp(-x^2-y^2)\".\n"
+            << "Then enter limits of 2 to " << MaxCubatureDims << " axes: x1 x2 y1 y2 [z1 z2 [w1 w2]].\n"
+            << std::endl;
+        return false;
+    }
+
+    argv += first;
+    args.ThreadsNumber = atoi(argv[0]);
+    args.Eps = atof(argv[1]);
+    args.StartBoxesCount = atoi(argv[2]);
+    args.TaskPacketSize = atoi(argv[3]);
+
+    if (strncmp(argv[4], "f=", 2) != 0)
+    {
+        std::cout << "Enter the integrand as f=EXPRESSION." << std::endl;
+        return false;
+    }
+    args.Function = argv[4] + 2;
+
+    args.Dims = (count - 5) / 2;
+    for (size_t axis = 0; axis < args.Dims; axis++)
+    {
+        args.Lower[axis] = atof(argv[5 + 2 * axis]);
+        args.Upper[axis] = atof(argv[6 + 2 * axis]);
+    }
+
+    if (args.ThreadsNumber == 0 || args.StartBoxesCount == 0)
+    {
+        std::cout << "Number of threads and start boxes must be positive." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool Integrate(const CubatureArgs& args, CubatureStats& stats)
+{
+    Expression expression;
+    std::string error;
+    if (!expression.Compile(args.Function, error))
+    {
+        std::cout << "Bad function " << args.Function << ": " << error << "." << std::endl;
+        return false;
+    }
+    if (expression.GetVariablesCount() > args.Dims)
+    {
+        std::cout << "Function " << args.Function << " has more variables than limits." << std::endl;
+        return false;
+    }
+
+    CConfig conf = {};
+    conf.ThreadsNumber = args.ThreadsNumber;
+    conf.DequesCount = args.ThreadsNumber;
+    conf.TaskToDoPacketSize = args.TaskPacketSize;
+    conf.Eps = args.Eps;
+    conf.Rule = CreateGenzMalikRule(args.Dims);
+    conf.Function = expression.GetMultiIntegrand();
+    conf.ActiveThreads = args.ThreadsNumber;
+    conf.StartBoxes.resize(args.ThreadsNumber);
+    conf.SharedTasks = std::make_unique<WorkStealingDeque<Box>[]>(args.ThreadsNumber);
+    conf.ThreadResults.resize(args.ThreadsNumber);
+
+    CreateStartBoxes(conf, args);
+
+    if (sem_init(&conf.ConfAccess, 0, 1))
+        return false;
+
+    std::vector<pthread_t> threads(args.ThreadsNumber);
+    for (size_t st = 0; st < args.ThreadsNumber; st++)
+    {
+        if (pthread_create(&threads[st], nullptr, ThreadFunction, &conf))
+            return false;
+    }
+
+    for (size_t st = 0; st < args.ThreadsNumber; st++)
+    {
+        if (pthread_join(threads[st], nullptr))
+            return false;
+    }
+
+    sem_destroy(&conf.ConfAccess);
+
+    stats.Result = ReduceTree(std::move(conf.ThreadResults)).Get();
+    stats.TasksDone = conf.TotalTasksDone;
+    stats.Evaluations = conf.TotalEvaluations;
+    return true;
+}
\ No newline at end of file
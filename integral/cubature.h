@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "expression.h"
+#include "integrator.h"
+
+const size_t MaxCubatureDims = ExpressionVariables;
+
+// Points of the Genz-Malik rule in dims dimensions.
+constexpr size_t GetGenzMalikPoints(size_t dims)
+{
+    return (static_cast<size_t>(1) << dims) + 2 * dims * dims + 2 * dims + 1;
+}
+
+const size_t MaxCubaturePoints = GetGenzMalikPoints(MaxCubatureDims);
+
+// Axis-aligned box, the task of the cubature. Boxes go through the scheduler of the 1D tasks,
+// see scheduler.h: private LIFO stacks, the oldest boxes are shared in Chase-Lev deques and
+// stolen by idle threads.
+struct Box
+{
+    double Center[MaxCubatureDims];
+    double HalfWidth[MaxCubatureDims];
+    // Degree 7 Genz-Malik integral over the box.
+    double Int;
+    // Axis of the largest fourth difference of F, the box is split across it.
+    uint64_t Axis;
+};
+
+struct CubatureArgs
+{
+    size_t ThreadsNumber;
+    double Eps;
+    // Start boxes along every axis.
+    size_t StartBoxesCount;
+    size_t TaskPacketSize;
+    // Expression of x, y, z and w.
+    const char* Function;
+    size_t Dims;
+    double Lower[MaxCubatureDims];
+    double Upper[MaxCubatureDims];
+};
+
+struct CubatureStats
+{
+    double Result;
+    size_t TasksDone;
+    size_t Evaluations;
+};
+
+// Parses argv[first...]. Prints the usage and returns false on errors.
+bool ParseCubatureArgs(int argc, char* argv[], int first, CubatureArgs& args);
+
+// Integrates F over the box by args.ThreadsNumber threads. A box is split in two across its axis,
+// the halves are accepted if their sum differs from the integral over the box by less than Eps.
+// Prints the problem and returns false on errors.
+bool Integrate(const CubatureArgs& args, CubatureStats& stats);
\ No newline at end of file
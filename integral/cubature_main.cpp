@@ -0,0 +1,51 @@
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+
+#include "../common/metrics.h"
+#include "cubature.h"
+
+int main(int argc, char* argv[])
+{
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    auto startTime = high_resolution_clock::now();
+
+    CubatureArgs args = {};
+    if (!ParseCubatureArgs(argc, argv, 1, args))
+        return EXIT_FAILURE;
+
+    CubatureStats stats = {};
+    if (!Integrate(args, stats))
+        return EXIT_FAILURE;
+
+    std::cout << std::setprecision(12);
+
+    auto stopTime = high_resolution_clock::now();
+    duration<double, std::milli> execTime = stopTime - startTime;
+
+    std::cout << "MAIN THREAD:\n"
+              << "\tDimensions     = " << args.Dims << "\n"
+              << "\tTasks done     = " << stats.TasksDone << "\n"
+              << "\tEvaluations    = " << stats.Evaluations << "\n"
+              << "\tResult         = " << stats.Result << "\n"
+              << "\tExecution time = " << execTime.count() << " ms\n"
+              << std::endl;
+
+    RunMetrics()
+        .Add("time", execTime.count() / 1000)
+        .Add("threads", args.ThreadsNumber)
+        .Add("tasks", stats.TasksDone)
+        .Add("evaluations", stats.Evaluations)
+        .Save();
+
+    std::ofstream file;
+    file.open("log.txt", std::ios::out | std::ios::trunc);
+    file << "Execution time = " << execTime.count() << " ms" << std::endl;
+    file.close();
+
+    return 0;
+}
\ No newline at end of file
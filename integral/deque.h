@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Chase-Lev work stealing deque.
+// The owner thread pushes and pops at the bottom (LIFO), other threads steal from the top (FIFO),
+// so thieves take the oldest, i.e. the largest, tasks.
+// Memory orders follow N. M. Le et al. "Correct and efficient work-stealing for weak memory models", 2013.
+// Items are copied word by word with relaxed atomics, because a thief may read a slot
+// that the owner is writing. Such a thief always loses the CAS on Top and drops the item.
+template <typename T>
+class WorkStealingDeque
+{
+    static_assert(std::is_trivially_copyable_v<T> && sizeof(T) % sizeof(uint64_t) == 0,
+                  "Deque items are copied as 64 bit words.");
+
+private:
+    static const size_t Words = sizeof(T) / sizeof(uint64_t);
+
+    struct Buffer
+    {
+        const int64_t Capacity;
+        std::unique_ptr<uint64_t[]> Items;
+
+        Buffer(int64_t capacity) :
+            Capacity(capacity),
+            Items(std::make_unique<uint64_t[]>(capacity * Words))
+        {
+        }
+
+        void Store(int64_t index, const T& item)
+        {
+            uint64_t words[Words] = {};
+            __builtin_memcpy(words, &item, sizeof(T));
+
+            uint64_t* slot = Items.get() + (index & (Capacity - 1)) * Words;
+            for (size_t st = 0; st < Words; st++)
+                std::atomic_ref<uint64_t>(slot[st]).store(words[st], std::memory_order_relaxed);
+        }
+
+        T Load(int64_t index) const
+        {
+            uint64_t words[Words] = {};
+
+            uint64_t* slot = Items.get() + (index & (Capacity - 1)) * Words;
+            for (size_t st = 0; st < Words; st++)
+                words[st] = std::atomic_ref<uint64_t>(slot[st]).load(std::memory_order_relaxed);
+
+            T item;
+            __builtin_memcpy(&item, words, sizeof(T));
+            return item;
+        }
+    };
+
+    alignas(64) std::atomic<int64_t> Top;
+    alignas(64) std::atomic<int64_t> Bottom;
+    std::atomic<Buffer*> Array;
+
+    // Buffers replaced by Grow() may still be read by thieves, they are freed with the deque.
+    std::vector<std::unique_ptr<Buffer>> Buffers;
+
+private:
+    Buffer* Grow(Buffer* array, int64_t top, int64_t bottom)
+    {
+        auto buffer = std::make_unique<Buffer>(array->Capacity * 2);
+        for (int64_t st = top; st < bottom; st++)
+            buffer->Store(st, array->Load(st));
+
+        Buffer* newArray = buffer.get();
+        Buffers.push_back(std::move(buffer));
+        Array.store(newArray, std::memory_order_release);
+        return newArray;
+    }
+
+public:
+    // capacity must be a power of 2.
+    WorkStealingDeque(size_t capacity = 1024) :
+        Top(0),
+        Bottom(0),
+        Array(nullptr)
+    {
+        Buffers.push_back(std::make_unique<Buffer>(capacity));
+        Array.store(Buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator = (const WorkStealingDeque&) = delete;
+
+    // Owner only.
+    void Push(const T& item)
+    {
+        int64_t bottom = Bottom.load(std::memory_order_relaxed);
+        int64_t top    = Top.load(std::memory_order_acquire);
+        Buffer* array  = Array.load(std::memory_order_relaxed);
+
+        if (bottom - top > array->Capacity - 1)
+            array = Grow(array, top, bottom);
+
+        array->Store(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        Bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only. Takes the newest item.
+    bool Pop(T& item)
+    {
+        int64_t bottom = Bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* array  = Array.load(std::memory_order_relaxed);
+        Bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = Top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            // Empty.
+            Bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = array->Load(bottom);
+        if (top == bottom)
+        {
+            // The last item, race with thieves.
+            bool won = Top.compare_exchange_strong(top, top + 1,
+                                                   std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed);
+            Bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        return true;
+    }
+
+    // Any thread. Takes the oldest item. Fails if the deque is empty or another thread took the item.
+    bool Steal(T& item)
+    {
+        int64_t top = Top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = Bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+            return false;
+
+        Buffer* array = Array.load(std::memory_order_acquire);
+        item = array->Load(top);
+        return Top.compare_exchange_strong(top, top + 1,
+                                           std::memory_order_seq_cst,
+                                           std::memory_order_relaxed);
+    }
+
+    // Approximate for other threads.
+    size_t Size() const
+    {
+        int64_t bottom = Bottom.load(std::memory_order_relaxed);
+        int64_t top    = Top.load(std::memory_order_relaxed);
+        return bottom > top ? bottom - top : 0;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#include "engine.h"
+#include "rules.h"
+
+struct EngineQuery
+{
+    IntQuery Params;
+
+    // Tasks of the query in stacks and deques. Counts are updated once per batch.
+    std::atomic<int64_t> PendingTasks;
+    // Sums of the threads by ProcNumber, merged by ReduceTree() when the query is over.
+    std::vector<SumAccumulator> ThreadResults;
+    std::atomic<size_t> TasksDone;
+    std::atomic<size_t> Evaluations;
+
+    std::promise<IntAnswer> Answer;
+    IntCallback Callback;
+};
+
+// Count tasks on the top of the private stack belong to Query.
+struct QueryRun
+{
+    EngineQuery* Query;
+    size_t Count;
+};
+
+// Runs tell the queries of the private tasks from bottom to top, the oldest tasks are shared
+// from the bottom.
+struct EngineThread : SchedulerThread<VectorStack<Task>, QueryTask>
+{
+    std::deque<QueryRun> Runs;
+};
+
+static void PushTasks(EngineThread& thread, EngineQuery* query, size_t count)
+{
+    if (count == 0)
+        return;
+
+    if (thread.Runs.size() > 0 && thread.Runs.back().Query == query)
+        thread.Runs.back().Count += count;
+    else
+        thread.Runs.push_back({query, count});
+}
+
+// Tasks are shared one by one with their query, submitted queries are new tasks.
+struct EnginePolicy
+{
+    using Item = QueryTask;
+    using Thread = EngineThread;
+    using Pool = EnginePool;
+
+    static size_t GetTasksCount(const EngineThread& thread)
+    {
+        return thread.Tasks.Size();
+    }
+
+    static size_t GetTasksCount(const QueryTask&)
+    {
+        return 1;
+    }
+
+    static bool TakeOldest(EngineThread& thread, QueryTask& task)
+    {
+        if (!thread.Tasks.TakeOldest(task.Task))
+            return false;
+
+        QueryRun& run = thread.Runs.front();
+        task.Query = run.Query;
+
+        if (--run.Count == 0)
+            thread.Runs.pop_front();
+        return true;
+    }
+
+    static void PushItem(EngineThread& thread, const QueryTask& task)
+    {
+        thread.Tasks.Push(task.Task);
+        PushTasks(thread, task.Query, 1);
+    }
+
+    static void DoTasks(EngineThread& thread, EnginePool& pool)
+    {
+        pool.Engine->DoTasks(thread);
+    }
+
+    static bool HasNewTasks(const EnginePool& pool)
+    {
+        return pool.Engine->SubmissionsCount.load() != 0;
+    }
+
+    static bool TakeNewTasks(EngineThread& thread, EnginePool& pool)
+    {
+        return pool.Engine->TakeQuery(thread);
+    }
+};
+
+IntEngine::IntEngine(size_t threadsNumber, size_t taskPacketSize) :
+    TaskToDoPacketSize(taskPacketSize),
+    ProcNumber(0),
+    Pool(),
+    SubmissionsCount(0),
+    UnfinishedQueries(0),
+    Running(false)
+{
+    Pool.ThreadsNumber = threadsNumber;
+    Pool.DequesCount = threadsNumber;
+    Pool.SharedTasks = std::make_unique<WorkStealingDeque<QueryTask>[]>(threadsNumber);
+    Pool.Engine = this;
+
+    sem_init(&SubmissionsAccess, 0, 1);
+}
+
+IntEngine::~IntEngine()
+{
+    Stop();
+    sem_destroy(&SubmissionsAccess);
+}
+
+bool IntEngine::Start()
+{
+    assert(Threads.empty());
+
+    // Threads start active, the engine leaves when it stops.
+    Pool.ActiveThreads = Pool.ThreadsNumber + 1;
+    Threads.resize(Pool.ThreadsNumber);
+    for (size_t st = 0; st < Pool.ThreadsNumber; st++)
+    {
+        if (pthread_create(&Threads[st], nullptr, ThreadFunction, this))
+        {
+            Pool.ActiveThreads -= Pool.ThreadsNumber - st;
+            Threads.resize(st);
+            Stop();
+            return false;
+        }
+    }
+
+    Running = true;
+    return true;
+}
+
+void IntEngine::Stop()
+{
+    Running = false;
+    if (Threads.empty())
+        return;
+
+    Wait();
+
+    // The threads exit when all of them are idle.
+    LeaveActiveThreads(Pool);
+
+    for (pthread_t thread : Threads)
+        pthread_join(thread, nullptr);
+    Threads.clear();
+    ProcNumber = 0;
+}
+
+void IntEngine::Wait()
+{
+    size_t unfinished = UnfinishedQueries.load();
+    while (unfinished != 0)
+    {
+        UnfinishedQueries.wait(unfinished);
+        unfinished = UnfinishedQueries.load();
+    }
+}
+
+bool IntEngine::Enqueue(EngineQuery* const* queries, size_t count)
+{
+    // Nothing would run the queries, their promises are broken.
+    if (!Running.load())
+    {
+        std::cout << "The engine is not running, " << count << " queries are rejected." << std::endl;
+        for (size_t st = 0; st < count; st++)
+            delete queries[st];
+        return false;
+    }
+
+    UnfinishedQueries += count;
+
+    sem_wait(&SubmissionsAccess);
+    Submissions.insert(Submissions.end(), queries, queries + count);
+    SubmissionsCount += count;
+    sem_post(&SubmissionsAccess);
+
+    WakeParkedThreads(Pool);
+    return true;
+}
+
+std::future<IntAnswer> IntEngine::Submit(const IntQuery& query)
+{
+    EngineQuery* engineQuery = new EngineQuery();
+    engineQuery->Params = query;
+    std::future<IntAnswer> answer = engineQuery->Answer.get_future();
+
+    Enqueue(&engineQuery, 1);
+    return answer;
+}
+
+std::vector<std::future<IntAnswer>> IntEngine::Submit(const std::vector<IntQuery>& queries)
+{
+    std::vector<EngineQuery*> engineQueries(queries.size());
+    std::vector<std::future<IntAnswer>> answers(queries.size());
+    for (size_t st = 0; st < queries.size(); st++)
+    {
+        engineQueries[st] = new EngineQuery();
+        engineQueries[st]->Params = queries[st];
+        answers[st] = engineQueries[st]->Answer.get_future();
+    }
+
+    Enqueue(engineQueries.data(), engineQueries.size());
+    return answers;
+}
+
+bool IntEngine::Submit(const IntQuery& query, IntCallback callback)
+{
+    EngineQuery* engineQuery = new EngineQuery();
+    engineQuery->Params = query;
+    engineQuery->Callback = std::move(callback);
+
+    return Enqueue(&engineQuery, 1);
+}
+
+void IntEngine::CompleteQuery(EngineQuery* query)
+{
+    // The threads added their sums before their last update of PendingTasks.
+    IntAnswer answer =
+    {
+        .Result      = ReduceTree(std::move(query->ThreadResults)).Get(),
+        .TasksDone   = query->TasksDone.load(),
+        .Evaluations = query->Evaluations.load()
+    };
+
+    if (query->Callback)
+        query->Callback(answer);
+    else
+        query->Answer.set_value(answer);
+
+    delete query;
+
+    if (UnfinishedQueries.fetch_sub(1) == 1)
+        UnfinishedQueries.notify_all();
+}
+
+// Accepted integrals go to the state of the sum mode of the query.
+template <Rule rule>
+static size_t DoQueryBatch(const Task* batch, size_t count, const IntQuery& params, VectorStack<Task>& tasks,
+                           SumAccumulator& result)
+{
+    switch (result.GetMode())
+    {
+        case SumMode::Plain:
+            return DoBatch<rule>(batch, count, params.Function, params.Eps, tasks, result.GetCompensated().Sum);
+
+        case SumMode::Neumaier:
+            return DoBatch<rule>(batch, count, params.Function, params.Eps, tasks, result.GetCompensated());
+
+        case SumMode::Exact:
+            return DoBatch<rule>(batch, count, params.Function, params.Eps, tasks, result.GetExact());
+    }
+    return 0;
+}
+
+// Batches are taken from the top run, so a batch has tasks of one query.
+void IntEngine::DoTasks(EngineThread& thread)
+{
+    Task batch[TasksBatchSize];
+
+    size_t tasksDone = 0;
+    while (tasksDone < TaskToDoPacketSize && thread.Tasks.Size() > 0)
+    {
+        QueryRun& run = thread.Runs.back();
+        EngineQuery* query = run.Query;
+        const IntQuery& params = query->Params;
+
+        size_t count = thread.Tasks.Pop(batch, std::min(TasksBatchSize, run.Count));
+
+        run.Count -= count;
+        if (run.Count == 0)
+            thread.Runs.pop_back();
+
+        size_t stackSize = thread.Tasks.Size();
+        SumAccumulator& result = query->ThreadResults[thread.ProcNumber];
+        size_t done = 0;
+        switch (params.Rule)
+        {
+            case Rule::Trapezoid:
+                done = DoQueryBatch<Rule::Trapezoid>(batch, count, params, thread.Tasks, result);
+                break;
+
+            case Rule::Simpson:
+                done = DoQueryBatch<Rule::Simpson>(batch, count, params, thread.Tasks, result);
+                break;
+
+            case Rule::GaussKronrod:
+                done = DoQueryBatch<Rule::GaussKronrod>(batch, count, params, thread.Tasks, result);
+                break;
+        }
+
+        size_t children = thread.Tasks.Size() - stackSize;
+        PushTasks(thread, query, children);
+        tasksDone += done;
+
+        query->TasksDone.fetch_add(done);
+        query->Evaluations.fetch_add(count * GetRulePoints(params.Rule));
+
+        // Children are still private, so the counter never drops below the real number of tasks.
+        int64_t delta = static_cast<int64_t>(children) - static_cast<int64_t>(count);
+        if (query->PendingTasks.fetch_add(delta) + delta == 0)
+            CompleteQuery(query);
+    }
+
+    thread.Profile.TasksDone += tasksDone;
+}
+
+// Takes the oldest submitted query and pushes its start tasks to the private stack.
+bool IntEngine::TakeQuery(EngineThread& thread)
+{
+    if (SubmissionsCount.load() == 0)
+        return false;
+
+    EngineQuery* query = nullptr;
+    sem_wait(&SubmissionsAccess);
+    if (Submissions.size() > 0)
+    {
+        query = Submissions.front();
+        Submissions.pop_front();
+        SubmissionsCount--;
+    }
+    sem_post(&SubmissionsAccess);
+
+    if (!query)
+        return false;
+
+    const IntQuery& params = query->Params;
+    size_t count = std::max<size_t>(params.StartIntervalsCount, 1);
+    double dx = (params.StopInt - params.StartInt) / static_cast<double>(count);
+
+    // Nobody else sees the query yet.
+    query->PendingTasks = count;
+    query->ThreadResults.assign(Pool.ThreadsNumber, SumAccumulator(params.Sum));
+
+    for (size_t st = 0; st < count; st++)
+    {
+        // The leftmost interval goes on top.
+        size_t index = count - 1 - st;
+        Task task =
+        {
+            .x1  = params.StartInt + index * dx,
+            .x2  = index + 1 == count ? params.StopInt : params.StartInt + (index + 1) * dx,
+            .f1  = 0,
+            .f2  = 0,
+            .Int = 0
+        };
+        query->Evaluations += InitTask(params.Rule, params.Function, task);
+        thread.Tasks.Push(task);
+    }
+    PushTasks(thread, query, count);
+
+    return true;
+}
+
+void IntEngine::Run()
+{
+    EngineThread thread = {};
+    thread.ProcNumber = ProcNumber++;
+    thread.Profile.Thread = thread.ProcNumber;
+    thread.SharedTasks = &Pool.SharedTasks[thread.ProcNumber];
+    thread.RandomState = 0x9E3779B97F4A7C15ull * (thread.ProcNumber + 1);
+
+    Scheduler<EnginePolicy>::Run(thread, Pool);
+}
+
+void* IntEngine::ThreadFunction(void* args)
+{
+    assert(args);
+
+    reinterpret_cast<IntEngine*>(args)->Run();
+    return nullptr;
+}
\ No newline at end of file
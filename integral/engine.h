@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "deque.h"
+#include "integrator.h"
+#include "scheduler.h"
+
+// One integral of F over [StartInt, StopInt].
+struct IntQuery
+{
+    ::Integrand Function;
+    double StartInt;
+    double StopInt;
+    double Eps;
+    ::Rule Rule;
+    // Equal start intervals, at least 1.
+    size_t StartIntervalsCount;
+    // Sums of the threads are merged in a fixed tree, exact ones do not depend on the scheduling.
+    SumMode Sum;
+};
+
+struct IntAnswer
+{
+    double Result;
+    size_t TasksDone;
+    size_t Evaluations;
+};
+
+// Called by a thread of the engine.
+using IntCallback = std::function<void(const IntAnswer&)>;
+
+struct EngineQuery;
+struct EngineThread;
+class IntEngine;
+
+// Task of a shared deque, private stacks keep the query of their tasks aside.
+struct QueryTask
+{
+    ::Task Task;
+    EngineQuery* Query;
+};
+
+// Scheduler state of the engine, see scheduler.h.
+struct EnginePool : SchedulerPool<QueryTask>
+{
+    IntEngine* Engine;
+};
+
+// Long-lived pool of integration threads for many integrals per process.
+// Submitted queries wait in a queue, an idle thread takes a query and creates its start tasks.
+// Tasks of all queries go through the same work stealing deques, so threads done with small
+// queries steal from large ones and a new query starts as soon as any thread is idle.
+// A query is over when its counter of pending tasks drops to zero.
+// Threads run the scheduler of the integrator, the engine counts as an active thread while
+// it runs, so idle threads wait for new queries instead of exiting.
+class IntEngine
+{
+    friend struct EnginePolicy;
+
+private:
+    const size_t TaskToDoPacketSize;
+
+    std::vector<pthread_t> Threads;
+    std::atomic<size_t> ProcNumber;
+    EnginePool Pool;
+
+    // Submission queue.
+    sem_t SubmissionsAccess;
+    std::deque<EngineQuery*> Submissions;
+    std::atomic<size_t> SubmissionsCount;
+
+    // Submitted and not answered queries.
+    std::atomic<size_t> UnfinishedQueries;
+
+    // Submissions are taken between Start() and Stop().
+    std::atomic<bool> Running;
+
+private:
+    static void* ThreadFunction(void* args);
+
+    void Run();
+    void DoTasks(EngineThread& thread);
+    bool TakeQuery(EngineThread& thread);
+    void CompleteQuery(EngineQuery* query);
+    // Deletes the queries and returns false if the engine is not running.
+    bool Enqueue(EngineQuery* const* queries, size_t count);
+
+public:
+    IntEngine(size_t threadsNumber, size_t taskPacketSize);
+    // Waits for the submitted queries.
+    ~IntEngine();
+
+    IntEngine(const IntEngine&) = delete;
+    IntEngine& operator = (const IntEngine&) = delete;
+
+    // Starts the threads, returns false on errors.
+    bool Start();
+    // Waits for the submitted queries and joins the threads.
+    void Stop();
+
+    // Queries submitted while the engine is not running are rejected: their futures throw
+    // std::future_error with broken_promise and callbacks are not called.
+    std::future<IntAnswer> Submit(const IntQuery& query);
+    // Puts all queries to the queue at once.
+    std::vector<std::future<IntAnswer>> Submit(const std::vector<IntQuery>& queries);
+    // Returns false if the query is rejected.
+    bool Submit(const IntQuery& query, IntCallback callback);
+
+    // Waits until all submitted queries are answered.
+    void Wait();
+};
\ No newline at end of file
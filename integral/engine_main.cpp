@@ -0,0 +1,154 @@
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "../common/metrics.h"
+#include "engine.h"
+#include "expression.h"
+
+// Reads queries "a b eps [rule] [sum=MODE] [f=EXPRESSION]" from stdin, one per line, integrates them
+// on one engine and prints "a b result" in the order of queries. The expression takes
+// the rest of the line, sin(1/x)/x is integrated without it.
+int main(int argc, char* argv[])
+{
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    if (argc != 4)
+    {
+        std::cout
+            << "Enter as the first argument number of threads.\n"
+            << "As the second argument enter start number of integration intervals of a query.\n"
+            << "As the third argument enter tasks packet size.\n"
+            << "Queries \"a b eps [rule] [sum=MODE] [f=EXPRESSION]\" are read from stdin, rule is trapezoid (default), simpson or gk15.\n"
+            << "MODE is plain (default), neumaier or exact, exact results do not depend on the scheduling.\n"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Compiled once per text, they outlive the engine.
+    std::map<std::string, std::unique_ptr<Expression>> functions;
+
+    size_t threadsNumber = atoi(argv[1]);
+    IntEngine engine(threadsNumber, atoi(argv[3]));
+    size_t startIntervalsCount = atoi(argv[2]);
+
+    auto startTime = high_resolution_clock::now();
+
+    if (!engine.Start())
+        return EXIT_FAILURE;
+
+    std::vector<IntQuery> queries;
+    std::vector<std::future<IntAnswer>> answers;
+
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        std::istringstream stream(line);
+        IntQuery query =
+        {
+            .Function            = IntIntegrand,
+            .StartInt            = 0,
+            .StopInt             = 0,
+            .Eps                 = 0,
+            .Rule                = Rule::Trapezoid,
+            .StartIntervalsCount = startIntervalsCount,
+            .Sum                 = SumMode::Plain
+        };
+
+        if (!(stream >> query.StartInt >> query.StopInt >> query.Eps))
+            continue;
+
+        std::string option;
+        while (stream >> option)
+        {
+            if (option == "trapezoid")
+                query.Rule = Rule::Trapezoid;
+            else if (option == "simpson")
+                query.Rule = Rule::Simpson;
+            else if (option == "gk15")
+                query.Rule = Rule::GaussKronrod;
+            else if (option.compare(0, 4, "sum=") == 0)
+            {
+                if (!ParseSumMode(option.c_str() + 4, query.Sum))
+                {
+                    std::cout << "Unknown summation " << option.substr(4) << ", use plain, neumaier or exact." << std::endl;
+                    return EXIT_FAILURE;
+                }
+            }
+            else if (option.compare(0, 2, "f=") == 0)
+            {
+                std::string rest;
+                std::getline(stream, rest);
+                std::string text = option.substr(2) + rest;
+
+                std::unique_ptr<Expression>& function = functions[text];
+                if (!function)
+                {
+                    function = std::make_unique<Expression>();
+                    std::string error;
+                    if (!function->Compile(text, error))
+                    {
+                        std::cout << "Bad function " << text << ": " << error << "." << std::endl;
+                        return EXIT_FAILURE;
+                    }
+                    if (function->GetVariablesCount() > 1)
+                    {
+                        std::cout << "Function " << text << " is not a function of x only." << std::endl;
+                        return EXIT_FAILURE;
+                    }
+                }
+                query.Function = function->GetIntegrand();
+            }
+            else
+            {
+                std::cout << "Unknown option " << option << ", use trapezoid, simpson, gk15, sum=MODE or f=EXPRESSION." << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        // Queries start while the rest is read.
+        queries.push_back(query);
+        answers.push_back(engine.Submit(query));
+    }
+
+    size_t tasksDone = 0;
+    size_t evaluations = 0;
+
+    std::cout << std::setprecision(12);
+    for (size_t st = 0; st < answers.size(); st++)
+    {
+        IntAnswer answer = answers[st].get();
+        tasksDone += answer.TasksDone;
+        evaluations += answer.Evaluations;
+        std::cout << queries[st].StartInt << " " << queries[st].StopInt << " " << answer.Result << "\n";
+    }
+
+    engine.Stop();
+
+    auto stopTime = high_resolution_clock::now();
+    duration<double, std::milli> execTime = stopTime - startTime;
+
+    std::cerr << "ENGINE:\n"
+              << "\tQueries        = " << answers.size() << "\n"
+              << "\tTasks done     = " << tasksDone << "\n"
+              << "\tEvaluations    = " << evaluations << "\n"
+              << "\tExecution time = " << execTime.count() << " ms\n"
+              << std::endl;
+
+    RunMetrics()
+        .Add("time", execTime.count() / 1000)
+        .Add("threads", threadsNumber)
+        .Add("queries", answers.size())
+        .Add("tasks", tasksDone)
+        .Add("evaluations", evaluations)
+        .Save();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,581 @@
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "expression.h"
+#include "vecsin.h"
+
+using Op = Expression::Op;
+using Operand = Expression::Operand;
+using OperandKind = Expression::OperandKind;
+using Instruction = Expression::Instruction;
+
+struct FunctionName
+{
+    const char* Name;
+    Op Operation;
+};
+
+static const FunctionName Functions[] =
+{
+    {"sin",  Op::Sin},
+    {"cos",  Op::Cos},
+    {"tan",  Op::Tan},
+    {"exp",  Op::Exp},
+    {"log",  Op::Log},
+    {"sqrt", Op::Sqrt},
+    {"abs",  Op::Abs},
+    {"atan", Op::Atan}
+};
+
+// Integer powers up to this are computed by products.
+const double MaxProductPower = 64;
+
+static bool IsUnary(Op operation)
+{
+    return operation != Op::Add && operation != Op::Sub && operation != Op::Mul &&
+           operation != Op::Div && operation != Op::Pow;
+}
+
+static double Apply(Op operation, double a, double b)
+{
+    switch (operation)
+    {
+        case Op::Add:  return a + b;
+        case Op::Sub:  return a - b;
+        case Op::Mul:  return a * b;
+        case Op::Div:  return a / b;
+        case Op::Pow:  return std::pow(a, b);
+        case Op::Neg:  return -a;
+        case Op::Sin:  return std::sin(a);
+        case Op::Cos:  return std::cos(a);
+        case Op::Tan:  return std::tan(a);
+        case Op::Exp:  return std::exp(a);
+        case Op::Log:  return std::log(a);
+        case Op::Sqrt: return std::sqrt(a);
+        case Op::Abs:  return std::abs(a);
+        case Op::Atan: return std::atan(a);
+    }
+    return 0;
+}
+
+// Syntax tree node. Constant subtrees are folded while parsing.
+struct Node
+{
+    enum class Type
+    {
+        X,
+        Constant,
+        Operation
+    };
+
+    Type NodeType;
+    double Value;
+    Op Operation;
+    int Left;
+    int Right;
+};
+
+// Recursive descent parser:
+//     sum     = product {("+" | "-") product}
+//     product = unary {("*" | "/") unary}
+//     unary   = ("-" | "+") unary | power
+//     power   = primary ["^" unary]
+//     primary = number | "x" | "y" | "z" | "w" | "pi" | "e" | function "(" sum ")" | "(" sum ")"
+struct Parser
+{
+    const std::string& Text;
+    size_t Position;
+    std::vector<Node> Nodes;
+    std::string Error;
+    // x counts even if it is not used.
+    size_t VariablesCount;
+
+    Parser(const std::string& text) :
+        Text(text),
+        Position(0),
+        VariablesCount(1)
+    {
+    }
+
+    char Peek()
+    {
+        while (Position < Text.size() && std::isspace(static_cast<unsigned char>(Text[Position])))
+            Position++;
+        return Position < Text.size() ? Text[Position] : '\0';
+    }
+
+    int Fail(const std::string& message)
+    {
+        if (Error.empty())
+            Error = message + " at position " + std::to_string(Position);
+        return -1;
+    }
+
+    int AddConstant(double value)
+    {
+        Nodes.push_back({Node::Type::Constant, value, Op::Add, -1, -1});
+        return Nodes.size() - 1;
+    }
+
+    int AddOperation(Op operation, int left, int right)
+    {
+        if (left < 0 || (!IsUnary(operation) && right < 0))
+            return -1;
+
+        bool constant = Nodes[left].NodeType == Node::Type::Constant &&
+                        (IsUnary(operation) || Nodes[right].NodeType == Node::Type::Constant);
+        if (constant)
+        {
+            double b = IsUnary(operation) ? 0 : Nodes[right].Value;
+            return AddConstant(Apply(operation, Nodes[left].Value, b));
+        }
+
+        Nodes.push_back({Node::Type::Operation, 0, operation, left, right});
+        return Nodes.size() - 1;
+    }
+
+    int ParseSum()
+    {
+        int node = ParseProduct();
+        while (node >= 0 && (Peek() == '+' || Peek() == '-'))
+        {
+            Op operation = Text[Position++] == '+' ? Op::Add : Op::Sub;
+            node = AddOperation(operation, node, ParseProduct());
+        }
+        return node;
+    }
+
+    int ParseProduct()
+    {
+        int node = ParseUnary();
+        while (node >= 0 && (Peek() == '*' || Peek() == '/'))
+        {
+            Op operation = Text[Position++] == '*' ? Op::Mul : Op::Div;
+            node = AddOperation(operation, node, ParseUnary());
+        }
+        return node;
+    }
+
+    int ParseUnary()
+    {
+        if (Peek() == '-')
+        {
+            Position++;
+            return AddOperation(Op::Neg, ParseUnary(), -1);
+        }
+        if (Peek() == '+')
+        {
+            Position++;
+            return ParseUnary();
+        }
+        return ParsePower();
+    }
+
+    int ParsePower()
+    {
+        int node = ParsePrimary();
+        if (node >= 0 && Peek() == '^')
+        {
+            Position++;
+            node = AddOperation(Op::Pow, node, ParseUnary());
+        }
+        return node;
+    }
+
+    int ParsePrimary()
+    {
+        char c = Peek();
+        if (c == '(')
+        {
+            Position++;
+            int node = ParseSum();
+            if (node < 0)
+                return -1;
+            if (Peek() != ')')
+                return Fail("Expected )");
+            Position++;
+            return node;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+        {
+            const char* start = Text.c_str() + Position;
+            char* end = nullptr;
+            double value = strtod(start, &end);
+            if (end == start)
+                return Fail("Bad number");
+            Position += end - start;
+            return AddConstant(value);
+        }
+
+        if (!std::isalpha(static_cast<unsigned char>(c)))
+            return Fail(c == '\0' ? "Unexpected end" : std::string("Unexpected ") + c);
+
+        size_t start = Position;
+        while (Position < Text.size() && std::isalpha(static_cast<unsigned char>(Text[Position])))
+            Position++;
+        std::string name = Text.substr(start, Position - start);
+
+        const char* variables[ExpressionVariables] = {"x", "y", "z", "w"};
+        for (size_t variable = 0; variable < ExpressionVariables; variable++)
+        {
+            if (name != variables[variable])
+                continue;
+
+            // Value is the index of the variable.
+            Nodes.push_back({Node::Type::X, static_cast<double>(variable), Op::Add, -1, -1});
+            VariablesCount = std::max(VariablesCount, variable + 1);
+            return Nodes.size() - 1;
+        }
+        if (name == "pi")
+            return AddConstant(M_PI);
+        if (name == "e")
+            return AddConstant(M_E);
+
+        for (const FunctionName& function : Functions)
+        {
+            if (name != function.Name)
+                continue;
+
+            if (Peek() != '(')
+                return Fail("Expected (");
+            Position++;
+            int argument = ParseSum();
+            if (argument < 0)
+                return -1;
+            if (Peek() != ')')
+                return Fail("Expected )");
+            Position++;
+            return AddOperation(function.Operation, argument, -1);
+        }
+
+        Position = start;
+        return Fail("Unknown name " + name);
+    }
+};
+
+// Emits instructions of a tree. Registers are reference counted, an operand of an
+// instruction releases one reference.
+struct CodeGenerator
+{
+    const std::vector<Node>& Nodes;
+    std::vector<Instruction>& Code;
+    std::vector<double>& Constants;
+    uint8_t References[ExpressionRegisters];
+    std::string Error;
+
+    CodeGenerator(const std::vector<Node>& nodes, std::vector<Instruction>& code, std::vector<double>& constants) :
+        Nodes(nodes),
+        Code(code),
+        Constants(constants),
+        References()
+    {
+    }
+
+    Operand AddConstant(double value)
+    {
+        Constants.push_back(value);
+        return {OperandKind::Constant, static_cast<uint16_t>(Constants.size() - 1)};
+    }
+
+    Operand Retain(Operand operand)
+    {
+        if (operand.Kind == OperandKind::Register)
+            References[operand.Index]++;
+        return operand;
+    }
+
+    void Free(Operand operand)
+    {
+        if (operand.Kind == OperandKind::Register)
+            References[operand.Index]--;
+    }
+
+    // The destination is taken before the operands are freed, so it differs from them.
+    Operand Emit(Op operation, Operand a, Operand b)
+    {
+        size_t dst = 0;
+        while (dst < ExpressionRegisters && References[dst] != 0)
+            dst++;
+
+        if (dst == ExpressionRegisters)
+        {
+            Error = "Expression is too deep";
+            return a;
+        }
+
+        References[dst] = 1;
+        Code.push_back({operation, static_cast<uint8_t>(dst), a, b});
+        Free(a);
+        Free(b);
+        return {OperandKind::Register, static_cast<uint16_t>(dst)};
+    }
+
+    // a^power by squaring.
+    Operand EmitProductPower(Operand a, unsigned power)
+    {
+        Operand result = {};
+        bool hasResult = false;
+        Operand square = a;
+
+        while (true)
+        {
+            if (power & 1)
+            {
+                if (hasResult)
+                    result = Emit(Op::Mul, result, Retain(square));
+                else
+                {
+                    result = Retain(square);
+                    hasResult = true;
+                }
+            }
+
+            power >>= 1;
+            if (power == 0)
+                break;
+
+            square = Emit(Op::Mul, Retain(square), square);
+        }
+
+        Free(square);
+        return result;
+    }
+
+    Operand Generate(int index)
+    {
+        const Node& node = Nodes[index];
+        switch (node.NodeType)
+        {
+            case Node::Type::X:
+                return {OperandKind::X, static_cast<uint16_t>(node.Value)};
+
+            case Node::Type::Constant:
+                return AddConstant(node.Value);
+
+            case Node::Type::Operation:
+                break;
+        }
+
+        Operand a = Generate(node.Left);
+
+        // B of unary operations is never read.
+        if (IsUnary(node.Operation))
+            return Emit(node.Operation, a, {OperandKind::X, 0});
+
+        const Node& right = Nodes[node.Right];
+        if (node.Operation == Op::Pow && right.NodeType == Node::Type::Constant &&
+            right.Value == std::floor(right.Value) && std::abs(right.Value) <= MaxProductPower)
+        {
+            if (right.Value == 0)
+            {
+                Free(a);
+                return AddConstant(1);
+            }
+
+            Operand product = EmitProductPower(a, static_cast<unsigned>(std::abs(right.Value)));
+            if (right.Value < 0)
+                return Emit(Op::Div, AddConstant(1), product);
+            return product;
+        }
+
+        Operand b = Generate(node.Right);
+        return Emit(node.Operation, a, b);
+    }
+};
+
+Expression::Expression() :
+    Result({OperandKind::X, 0}),
+    VariablesCount(1)
+{
+}
+
+bool Expression::Compile(const std::string& text, std::string& error)
+{
+    Parser parser(text);
+    int root = parser.ParseSum();
+    if (root >= 0 && parser.Peek() != '\0')
+        root = parser.Fail(std::string("Unexpected ") + parser.Text[parser.Position]);
+
+    if (root < 0)
+    {
+        error = parser.Error;
+        return false;
+    }
+
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    CodeGenerator generator(parser.Nodes, code, constants);
+    Operand result = generator.Generate(root);
+    if (!generator.Error.empty())
+    {
+        error = generator.Error;
+        return false;
+    }
+
+    Code = std::move(code);
+    Constants = std::move(constants);
+    Result = result;
+    VariablesCount = parser.VariablesCount;
+    return true;
+}
+
+template <typename Function>
+static void ExecuteBinary(double* __restrict__ dst, const double* a, double ca, const double* b, double cb,
+                          size_t lanes, Function operation)
+{
+    if (a && b)
+    {
+        for (size_t st = 0; st < lanes; st++)
+            dst[st] = operation(a[st], b[st]);
+    }
+    else if (a)
+    {
+        for (size_t st = 0; st < lanes; st++)
+            dst[st] = operation(a[st], cb);
+    }
+    else
+    {
+        for (size_t st = 0; st < lanes; st++)
+            dst[st] = operation(ca, b[st]);
+    }
+}
+
+template <typename Function>
+static void ExecuteUnary(double* __restrict__ dst, const double* __restrict__ a, size_t lanes, Function operation)
+{
+    for (size_t st = 0; st < lanes; st++)
+        dst[st] = operation(a[st]);
+}
+
+void Expression::Evaluate(const double* x, double* f, size_t count) const
+{
+    Evaluate(&x, f, count);
+}
+
+void Expression::Evaluate(const double* const* x, double* f, size_t count) const
+{
+    double registers[ExpressionRegisters][ExpressionLanes];
+
+    for (size_t first = 0; first < count; first += ExpressionLanes)
+    {
+        size_t lanes = std::min(ExpressionLanes, count - first);
+
+        // nullptr for constants.
+        auto getLanes = [&](Operand operand) -> const double*
+        {
+            switch (operand.Kind)
+            {
+                case OperandKind::X:
+                    return x[operand.Index] + first;
+                case OperandKind::Register:
+                    return registers[operand.Index];
+                case OperandKind::Constant:
+                    return nullptr;
+            }
+            return nullptr;
+        };
+
+        for (const Instruction& instruction : Code)
+        {
+            double* dst = registers[instruction.Dst];
+            const double* a = getLanes(instruction.A);
+            const double* b = getLanes(instruction.B);
+            double ca = a ? 0 : Constants[instruction.A.Index];
+            double cb = b ? 0 : Constants[instruction.B.Index];
+
+            switch (instruction.Operation)
+            {
+                case Op::Add:
+                    ExecuteBinary(dst, a, ca, b, cb, lanes, [](double u, double v) { return u + v; });
+                    break;
+                case Op::Sub:
+                    ExecuteBinary(dst, a, ca, b, cb, lanes, [](double u, double v) { return u - v; });
+                    break;
+                case Op::Mul:
+                    ExecuteBinary(dst, a, ca, b, cb, lanes, [](double u, double v) { return u * v; });
+                    break;
+                case Op::Div:
+                    ExecuteBinary(dst, a, ca, b, cb, lanes, [](double u, double v) { return u / v; });
+                    break;
+                case Op::Pow:
+                    ExecuteBinary(dst, a, ca, b, cb, lanes, [](double u, double v) { return std::pow(u, v); });
+                    break;
+                case Op::Neg:
+                    ExecuteUnary(dst, a, lanes, [](double u) { return -u; });
+                    break;
+                case Op::Sin:
+                    SinBatch(a, dst, lanes);
+                    break;
+                case Op::Cos:
+                    CosBatch(a, dst, lanes);
+                    break;
+                case Op::Tan:
+                {
+                    double cos[ExpressionLanes];
+                    SinBatch(a, dst, lanes);
+                    CosBatch(a, cos, lanes);
+                    for (size_t st = 0; st < lanes; st++)
+                        dst[st] /= cos[st];
+                    break;
+                }
+                case Op::Exp:
+                    ExecuteUnary(dst, a, lanes, [](double u) { return std::exp(u); });
+                    break;
+                case Op::Log:
+                    ExecuteUnary(dst, a, lanes, [](double u) { return std::log(u); });
+                    break;
+                case Op::Sqrt:
+                    ExecuteUnary(dst, a, lanes, [](double u) { return std::sqrt(u); });
+                    break;
+                case Op::Abs:
+                    ExecuteUnary(dst, a, lanes, [](double u) { return std::abs(u); });
+                    break;
+                case Op::Atan:
+                    ExecuteUnary(dst, a, lanes, [](double u) { return std::atan(u); });
+                    break;
+            }
+        }
+
+        const double* result = getLanes(Result);
+        if (result)
+            std::copy(result, result + lanes, f + first);
+        else
+            std::fill(f + first, f + first + lanes, Constants[Result.Index]);
+    }
+}
+
+double Expression::Evaluate(double x) const
+{
+    double f = 0;
+    Evaluate(&x, &f, 1);
+    return f;
+}
+
+Integrand Expression::GetIntegrand() const
+{
+    return Integrand
+    {
+        .Batch = [](const void* context, const double* x, double* f, size_t count)
+        {
+            static_cast<const Expression*>(context)->Evaluate(x, f, count);
+        },
+        .Context = this
+    };
+}
+
+MultiIntegrand Expression::GetMultiIntegrand() const
+{
+    return MultiIntegrand
+    {
+        .Batch = [](const void* context, const double* const* x, double* f, size_t count)
+        {
+            static_cast<const Expression*>(context)->Evaluate(x, f, count);
+        },
+        .Context = this
+    };
+}
\ No newline at end of file
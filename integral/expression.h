@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "integrator.h"
+
+// Points of a chunk evaluated by one pass over the bytecode.
+const size_t ExpressionLanes = 64;
+
+// Registers of a compiled expression.
+const size_t ExpressionRegisters = 16;
+
+// Variables x, y, z and w.
+const size_t ExpressionVariables = 4;
+
+// Integrand given as a text, a function of x or of x, y, z, w. Numbers, variables, pi, e,
+// + - * / ^, parentheses and sin, cos, tan, exp, log, sqrt, abs, atan are supported,
+// e.g. "sin(1/x)^2/x^2".
+// The text is compiled to a register bytecode with constants folded and integer powers
+// turned into products. Points are evaluated by chunks of ExpressionLanes: every instruction
+// is a loop over the chunk, so arithmetic, sqrt, sin and cos run on SIMD lanes.
+// exp, log, atan and non-integer powers call libm per point.
+class Expression
+{
+public:
+    enum class Op : uint8_t
+    {
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Pow,
+        Neg,
+        Sin,
+        Cos,
+        Tan,
+        Exp,
+        Log,
+        Sqrt,
+        Abs,
+        Atan
+    };
+
+    enum class OperandKind : uint8_t
+    {
+        // Variable, Index is 0 for x, 1 for y and so on.
+        X,
+        Register,
+        Constant
+    };
+
+    struct Operand
+    {
+        OperandKind Kind;
+        // Register or constant index.
+        uint16_t Index;
+    };
+
+    // Dst = Op(A, B), B is unused by unary operations. Dst is never one of the operands.
+    struct Instruction
+    {
+        Op Operation;
+        uint8_t Dst;
+        Operand A;
+        Operand B;
+    };
+
+private:
+    std::vector<Instruction> Code;
+    std::vector<double> Constants;
+    Operand Result;
+    // 1 + the index of the last used variable.
+    size_t VariablesCount;
+
+public:
+    Expression();
+
+    // Returns false and describes the problem in error on bad texts.
+    bool Compile(const std::string& text, std::string& error);
+
+    // f[i] = F(x[i]).
+    void Evaluate(const double* x, double* f, size_t count) const;
+    double Evaluate(double x) const;
+    // f[i] = F(x[0][i], x[1][i], ...) for GetVariablesCount() coordinates.
+    void Evaluate(const double* const* x, double* f, size_t count) const;
+
+    // Both refer to the expression, which must outlive them.
+    ::Integrand GetIntegrand() const;
+    ::MultiIntegrand GetMultiIntegrand() const;
+
+    size_t GetVariablesCount() const
+    {
+        return VariablesCount;
+    }
+
+    const std::vector<Instruction>& GetCode() const
+    {
+        return Code;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+
+// Integrand f(x) = Amplitude(x) sin(Phase(x)) with a smooth amplitude and a monotone phase.
+// With u = Phase(x) the integral over [x1, x2] is the integral of h(u) sin(u) over [Phase(x1), Phase(x2)],
+// h = Amplitude / PhaseDerivative at x = InversePhase(u), and h varies slowly where f oscillates fast.
+struct OscillatoryIntegrand
+{
+    double (*Amplitude)(double x);
+    double (*Phase)(double x);
+    double (*PhaseDerivative)(double x);
+    double (*InversePhase)(double u);
+};
+
+inline double GetFilonAmplitude(const OscillatoryIntegrand& integrand, double u)
+{
+    double x = integrand.InversePhase(u);
+    return integrand.Amplitude(x) / integrand.PhaseDerivative(x);
+}
+
+// Filon rule: integral of p(u) sin(u) over [u1, u2], where p is the parabola through
+// (u1, h1), (um, hm), (u2, h2) and um is the midpoint. Moments of sin are exact,
+// so the error does not grow with the number of oscillations. u2 < u1 is allowed.
+inline double ComputeFilon(double u1, double u2, double h1, double hm, double h2)
+{
+    // p(um + t) = a0 + a1 t + a2 t^2, t in [-d, d].
+    double d = (u2 - u1) / 2;
+    double a0 = hm;
+    double a1 = (h2 - h1) / (2 * d);
+    double a2 = (h2 - 2 * hm + h1) / (2 * d * d);
+
+    double sin1 = std::sin(u1);
+    double cos1 = std::cos(u1);
+    double sin2 = std::sin(u2);
+    double cos2 = std::cos(u2);
+
+    // Antiderivatives of t^k sin(um + t):
+    //     -cos, -t cos + sin, -t^2 cos + 2 t sin + 2 cos.
+    double i0 = -cos2 + cos1;
+    double i1 = (-d * cos2 + sin2) - (d * cos1 + sin1);
+    double i2 = (-d * d * cos2 + 2 * d * sin2 + 2 * cos2) - (-d * d * cos1 - 2 * d * sin1 + 2 * cos1);
+
+    return a0 * i0 + a1 * i1 + a2 * i2;
+}
\ No newline at end of file
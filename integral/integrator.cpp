@@ -0,0 +1,936 @@
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#include "../common/counters.h"
+#include "expression.h"
+#include "integrator.h"
+#include "partition.h"
+#include "rules.h"
+#include "vecsin.h"
+
+struct TConfig : SchedulerThread<TaskStack, TaskChunk*>
+{
+    SumAccumulator Result;
+    std::deque<AcceptedSplit> Accepted;
+};
+
+const OscillatoryIntegrand IntOscillation =
+{
+    .Amplitude       = [](double x) { return 1/x; },
+    .Phase           = [](double x) { return 1/x; },
+    .PhaseDerivative = [](double x) { return -1/(x*x); },
+    .InversePhase    = [](double u) { return 1/u; }
+};
+
+// Default integrand sin(1/x)/x, other ones are given as expressions, see expression.h.
+void IntFunctBatch(const double* __restrict__ x, double* __restrict__ f, size_t count)
+{
+    assert(count <= TasksBatchSize * MaxRulePoints);
+
+    double inv[TasksBatchSize * MaxRulePoints];
+    for (size_t st = 0; st < count; st++)
+        inv[st] = 1/x[st];
+
+    SinBatch(inv, f, count);
+
+    for (size_t st = 0; st < count; st++)
+        f[st] *= inv[st];
+}
+
+const Integrand IntIntegrand =
+{
+    .Batch   = [](const void*, const double* x, double* f, size_t count) { IntFunctBatch(x, f, count); },
+    .Context = nullptr
+};
+
+// Takes up to TasksBatchSize tasks from the top of the stack at once, evaluates all new points
+// in one vectorized call and then accepts or subdivides every task of the batch.
+template <Rule rule, typename Sum>
+void DoTasks(TConfig& tconf, GConfig& gconf, Sum& result)
+{
+    Task batch[TasksBatchSize];
+
+    size_t tasksDone = 0;
+    while (tasksDone < gconf.TaskToDoPacketSize && tconf.Tasks.Size() > 0)
+    {
+        size_t count = tconf.Tasks.Pop(batch, TasksBatchSize);
+
+        tasksDone += DoBatch<rule>(batch, count, gconf.Function, gconf.Eps, tconf.Tasks, result,
+                                   gconf.KeepAccepted ? &tconf.Accepted : nullptr);
+        tconf.Profile.Evaluations += count * GetRulePoints<rule>();
+    }
+
+    tconf.Profile.TasksDone += tasksDone;
+}
+
+// Accepted integrals go to the state of the sum mode, the mode is not switched per task.
+template <Rule rule>
+void DoTasks(TConfig& tconf, GConfig& gconf)
+{
+    switch (tconf.Result.GetMode())
+    {
+        case SumMode::Plain:
+            DoTasks<rule>(tconf, gconf, tconf.Result.GetCompensated().Sum);
+            break;
+
+        case SumMode::Neumaier:
+            DoTasks<rule>(tconf, gconf, tconf.Result.GetCompensated());
+            break;
+
+        case SumMode::Exact:
+            DoTasks<rule>(tconf, gconf, tconf.Result.GetExact());
+            break;
+    }
+}
+
+void DoTasks(TConfig& tconf, GConfig& gconf)
+{
+    switch (gconf.Rule)
+    {
+        case Rule::Trapezoid:
+            DoTasks<Rule::Trapezoid>(tconf, gconf);
+            break;
+
+        case Rule::Simpson:
+            DoTasks<Rule::Simpson>(tconf, gconf);
+            break;
+
+        case Rule::GaussKronrod:
+            DoTasks<Rule::GaussKronrod>(tconf, gconf);
+            break;
+    }
+}
+
+struct FilonTask
+{
+    double x1;
+    double x2;
+    double u1;
+    double u2;
+    // h at u1, the midpoint and u2.
+    double h1;
+    double hm;
+    double h2;
+    double Int;
+};
+
+// Integrates [x1, x2] by bisection in the phase with the Filon rule. Halves with less than
+// FilonMinPhase of phase are added to intervals, they are left for the selected rule.
+static double IntegrateOscillatory(const GConfig& gconf, double x1, double x2, std::vector<Interval>& intervals, FilonStats& stats)
+{
+    const OscillatoryIntegrand& integrand = *gconf.Oscillation;
+
+    FilonTask task = {};
+    task.x1 = x1;
+    task.x2 = x2;
+    task.u1 = integrand.Phase(x1);
+    task.u2 = integrand.Phase(x2);
+    task.h1 = GetFilonAmplitude(integrand, task.u1);
+    task.hm = GetFilonAmplitude(integrand, (task.u1 + task.u2) / 2);
+    task.h2 = GetFilonAmplitude(integrand, task.u2);
+    task.Int = ComputeFilon(task.u1, task.u2, task.h1, task.hm, task.h2);
+    stats.Evaluations += 3;
+
+    std::vector<FilonTask> stack = {task};
+    double result = 0;
+
+    while (stack.size() > 0)
+    {
+        task = stack.back();
+        stack.pop_back();
+
+        double um = (task.u1 + task.u2) / 2;
+        double xm = integrand.InversePhase(um);
+
+        FilonTask t1 =
+        {
+            .x1  = task.x1,
+            .x2  = xm,
+            .u1  = task.u1,
+            .u2  = um,
+            .h1  = task.h1,
+            .hm  = GetFilonAmplitude(integrand, (task.u1 + um) / 2),
+            .h2  = task.hm,
+            .Int = 0
+        };
+        t1.Int = ComputeFilon(t1.u1, t1.u2, t1.h1, t1.hm, t1.h2);
+
+        FilonTask t2 =
+        {
+            .x1  = xm,
+            .x2  = task.x2,
+            .u1  = um,
+            .u2  = task.u2,
+            .h1  = task.hm,
+            .hm  = GetFilonAmplitude(integrand, (um + task.u2) / 2),
+            .h2  = task.h2,
+            .Int = 0
+        };
+        t2.Int = ComputeFilon(t2.u1, t2.u2, t2.h1, t2.hm, t2.h2);
+
+        stats.TasksDone++;
+        stats.Evaluations += 2;
+
+        if (std::abs(task.Int - (t1.Int + t2.Int)) < gconf.Eps)
+        {
+            result += t1.Int + t2.Int;
+        }
+        else if (std::abs(um - task.u1) >= FilonMinPhase)
+        {
+            stack.push_back(t1);
+            stack.push_back(t2);
+        }
+        else
+        {
+            // Few oscillations, back to the selected rule.
+            intervals.push_back({t1.x1, t1.x2});
+            intervals.push_back({t2.x1, t2.x2});
+        }
+    }
+
+    return result;
+}
+
+// Whole chunks of the private stacks go through the shared deques.
+struct IntegratorPolicy
+{
+    using Item = TaskChunk*;
+    using Thread = TConfig;
+    using Pool = GConfig;
+
+    static size_t GetTasksCount(const TConfig& tconf)
+    {
+        return tconf.Tasks.Size();
+    }
+
+    static size_t GetTasksCount(const TaskChunk* chunk)
+    {
+        return ::GetTasksCount(*chunk);
+    }
+
+    static bool TakeOldest(TConfig& tconf, TaskChunk*& chunk)
+    {
+        chunk = tconf.Tasks.TakeOldest();
+        return chunk != nullptr;
+    }
+
+    static void PushItem(TConfig& tconf, TaskChunk* chunk)
+    {
+        tconf.Tasks.PushChunk(chunk);
+    }
+
+    static void DoTasks(TConfig& tconf, GConfig& gconf)
+    {
+        ::DoTasks(tconf, gconf);
+    }
+
+    static bool HasNewTasks(const GConfig&)
+    {
+        return false;
+    }
+
+    static bool TakeNewTasks(TConfig&, GConfig&)
+    {
+        return false;
+    }
+};
+
+static double LockGConf(GConfig& gconf)
+{
+    auto start = ProfileClock::now();
+    sem_wait(&gconf.GConfAccess);
+    return std::chrono::duration<double, std::milli>(ProfileClock::now() - start).count();
+}
+
+void* threadFunction(void* args)
+{
+    assert(args);
+
+    GConfig* const gconf = static_cast<GConfig*>(args);
+    TConfig tconf = {};
+
+    tconf.ProcNumber = gconf->ProcNumber++;
+    tconf.Profile.Thread = tconf.ProcNumber;
+    tconf.Tasks = std::move(gconf->StartTasks[tconf.ProcNumber]);
+    tconf.SharedTasks = &gconf->SharedTasks[tconf.ProcNumber];
+    tconf.RandomState = 0x9E3779B97F4A7C15ull * (tconf.ProcNumber + 1);
+    tconf.Result = SumAccumulator(gconf->Result.GetMode());
+
+    int cpu = -1;
+    if (!gconf->Places.empty())
+    {
+        const CpuPlace& place = gconf->Places[tconf.ProcNumber];
+        if (PinThread(place.Cpu))
+            cpu = place.Cpu;
+
+        tconf.Tasks.MoveTo(gconf->NodeArenas[place.Node]);
+        for (size_t st = 0; st < gconf->ThreadsNumber; st++)
+        {
+            if (st != tconf.ProcNumber && gconf->Places[st].Package == place.Package)
+                tconf.Neighbours.push_back(st);
+        }
+    }
+
+    tconf.Profile.LockWaitTime += LockGConf(*gconf);
+    std::cout << "THREAD[" << tconf.ProcNumber << "] inited";
+    if (cpu >= 0)
+        std::cout << " on CPU " << cpu;
+    std::cout << "." << std::endl;
+    sem_post(&gconf->GConfAccess);
+
+    // Every thread starts active with its share of the initial tasks. The counters are read once
+    // per thread, so steals and parks are in the region too. Flops depend on the integrand,
+    // so only the hardware counters are reported.
+    {
+        CounterRegion region("Worker");
+        Scheduler<IntegratorPolicy>::Run(tconf, *gconf);
+    }
+
+    tconf.Profile.LockWaitTime += LockGConf(*gconf);
+    
+    std::cout << "THREAD[" << tconf.ProcNumber << "]:\n"
+              << "\tTasks done      = " << tconf.Profile.TasksDone << "\n"
+              << "\tEvaluations     = " << tconf.Profile.Evaluations << "\n"
+              << "\tTasks shared    = " << tconf.Profile.TasksShared << "\n"
+              << "\tTasks stolen    = " << tconf.Profile.TasksStolen << "\n"
+              << "\tMax tasks count = " << tconf.Profile.MaxTasksCount << "\n" 
+              << std::endl;
+    
+    gconf->ThreadResults[tconf.ProcNumber] = tconf.Result;
+    gconf->TotalTasksDone += tconf.Profile.TasksDone;
+    gconf->TotalEvaluations += tconf.Profile.Evaluations;
+    if (gconf->KeepAccepted)
+        gconf->Accepted.push_back(std::move(tconf.Accepted));
+    if (gconf->Profile)
+    {
+        tconf.Profile.LockWaitTime += tconf.Tasks.GetLockWaitTime();
+        gconf->Profiles.push_back(std::move(tconf.Profile));
+    }
+
+    sem_post(&gconf->GConfAccess);
+
+    return 0;
+}
+
+bool ParseIntArgs(int argc, char* argv[], int first, IntArgs& args)
+{
+    int count = argc - first;
+    if (count < 6 || count > 15)
+    {
+        std::cout
+            << "Enter as the first argument number of threads.\n"
+            << "As the second argument enter start integration limit.\n"
+            << "As the third argument enter stop integration limit.\n"
+            << "As the fourth argument enter epsilon.\n"
+            << "As the fifth argument enter start number of integration intervals.\n"
+            << "As the sixth argument enter tasks packet size.\n"
+            << "Optional arguments in any order:\n"
+            << "\trule: trapezoid (default), simpson or gk15;\n"
+            << "\tfilon to integrate intervals with many oscillations by the Filon rule;\n"
+            << "\tf=EXPRESSION of x to integrate instead of sin(1/x)/x, e.g. f=\"sin(1/x)^2/x^2\";\n"
+            << "\tload=FILE to refine the partition saved by a run with a larger epsilon;\n"
+            << "\tsave=FILE to save the partition;\n"
+            << "\tprofile=FILE to save counters and queue depths of the threads in JSON;\n"
+            << "\ttrace=FILE to save spans and queue depths of the threads as a Chrome trace;\n"
+            << "\tpin=POLICY to pin the threads to the CPUs: compact, scatter, physical or none (default);\n"
+            << "\tsum=MODE to sum the results: plain (default), neumaier or exact, exact sums do not depend\n"
+            << "\t\ton the tasks done by every thread.\n"
+            << std::endl;
+        return false;
+    }
+
+    argv += first;
+
+    args.ThreadsNumber = atoi(argv[0]);
+    args.StartInt = atof(argv[1]);
+    args.StopInt = atof(argv[2]);
+    args.Eps = atof(argv[3]);
+    args.StartIntervalsCount = atoi(argv[4]);
+    args.TaskPacketSize = atoi(argv[5]);
+
+    args.Rule = Rule::Trapezoid;
+    args.Filon = false;
+    args.Function = nullptr;
+    args.PartitionInput = nullptr;
+    args.PartitionOutput = nullptr;
+    args.ProfileOutput = nullptr;
+    args.TraceOutput = nullptr;
+    args.Pin = PinPolicy::None;
+    args.Sum = SumMode::Plain;
+
+    for (int st = 6; st < count; st++)
+    {
+        if (strcmp(argv[st], "trapezoid") == 0)
+            args.Rule = Rule::Trapezoid;
+        else if (strcmp(argv[st], "simpson") == 0)
+            args.Rule = Rule::Simpson;
+        else if (strcmp(argv[st], "gk15") == 0)
+            args.Rule = Rule::GaussKronrod;
+        else if (strcmp(argv[st], "filon") == 0)
+            args.Filon = true;
+        else if (strncmp(argv[st], "f=", 2) == 0)
+            args.Function = argv[st] + 2;
+        else if (strncmp(argv[st], "load=", 5) == 0)
+            args.PartitionInput = argv[st] + 5;
+        else if (strncmp(argv[st], "save=", 5) == 0)
+            args.PartitionOutput = argv[st] + 5;
+        else if (strncmp(argv[st], "profile=", 8) == 0)
+            args.ProfileOutput = argv[st] + 8;
+        else if (strncmp(argv[st], "trace=", 6) == 0)
+            args.TraceOutput = argv[st] + 6;
+        else if (strncmp(argv[st], "pin=", 4) == 0)
+        {
+            if (!ParsePinPolicy(argv[st] + 4, args.Pin))
+            {
+                std::cout << "Unknown pin policy " << argv[st] + 4 << ", use compact, scatter, physical or none." << std::endl;
+                return false;
+            }
+        }
+        else if (strncmp(argv[st], "sum=", 4) == 0)
+        {
+            if (!ParseSumMode(argv[st] + 4, args.Sum))
+            {
+                std::cout << "Unknown summation " << argv[st] + 4 << ", use plain, neumaier or exact." << std::endl;
+                return false;
+            }
+        }
+        else
+        {
+            std::cout << "Unknown option " << argv[st] << ", use trapezoid, simpson, gk15, filon, f=EXPRESSION, "
+                      << "load=FILE, save=FILE, profile=FILE, trace=FILE, pin=POLICY or sum=MODE." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool InitGConfig(GConfig& gconf, const IntArgs& args, size_t extraDeques)
+{
+    gconf.ThreadsNumber = args.ThreadsNumber;
+    gconf.DequesCount = args.ThreadsNumber + extraDeques;
+    gconf.ActiveThreads = args.ThreadsNumber + extraDeques;
+    gconf.Eps = args.Eps;
+    gconf.Rule = args.Rule;
+    gconf.TaskToDoPacketSize = args.TaskPacketSize;
+    gconf.Result = SumAccumulator(args.Sum);
+    gconf.ThreadResults.assign(gconf.ThreadsNumber, SumAccumulator(args.Sum));
+    gconf.SharedTasks = std::make_unique<TaskDeque[]>(gconf.DequesCount);
+    for (size_t st = 0; st < gconf.ThreadsNumber; st++)
+        gconf.StartTasks.emplace_back(gconf.Arena);
+
+    gconf.Function = IntIntegrand;
+    gconf.Form = &IntOscillation;
+    if (args.Function)
+    {
+        auto expression = std::make_shared<Expression>();
+        std::string error;
+        if (!expression->Compile(args.Function, error))
+        {
+            std::cout << "Bad function " << args.Function << ": " << error << "." << std::endl;
+            return false;
+        }
+        if (expression->GetVariablesCount() > 1)
+        {
+            std::cout << "Function " << args.Function << " is not a function of x only, use cint for cubature." << std::endl;
+            return false;
+        }
+
+        gconf.UserFunction = expression;
+        gconf.Function = expression->GetIntegrand();
+        gconf.Form = nullptr;
+    }
+
+    if (args.Filon && !gconf.Form)
+    {
+        std::cout << "The Filon rule needs the oscillatory form of the integrand, it is known for sin(1/x)/x only." << std::endl;
+        return false;
+    }
+    gconf.Oscillation = args.Filon ? gconf.Form : nullptr;
+
+    // Filon intervals are not in the partition.
+    if (args.Filon && (args.PartitionInput || args.PartitionOutput))
+    {
+        std::cout << "Partition files can not be used with the Filon rule." << std::endl;
+        return false;
+    }
+    gconf.KeepAccepted = args.PartitionOutput != nullptr;
+
+    gconf.Profile = args.ProfileOutput || args.TraceOutput;
+    gconf.StartTime = ProfileClock::now();
+
+    if (args.Pin != PinPolicy::None)
+    {
+        // Ranks of a host should be bound to disjoint CPUs by mpirun, the threads are placed in them.
+        Topology topology;
+        if (!topology.Load())
+            return false;
+
+        gconf.Places = topology.Place(args.Pin, gconf.ThreadsNumber);
+        gconf.NodeArenas = std::make_unique<TaskArena[]>(topology.GetNodesCount());
+    }
+
+    return true;
+}
+
+static double GetErrorOrder(Rule rule)
+{
+    switch (rule)
+    {
+        case Rule::Trapezoid:
+            return 2;
+        case Rule::Simpson:
+            return 4;
+        case Rule::GaussKronrod:
+            return 22;
+    }
+    return 2;
+}
+
+// Work density of the integrand at ascending sample points, empty if the oscillatory form is known
+// or the range is empty.
+struct DensityTable
+{
+    std::vector<double> X;
+    std::vector<double> Values;
+};
+
+// Leaves of the bisection have error ~ eps. The error of a rule of order p on an interval
+// of length h is ~ h^(p+1) |f^(p)| and |f^(p)| ~ A w^p for f = A sin(Phase), w = |Phase'|,
+// so there are (A w^p / eps)^(1/(p+1)) tasks per unit length.
+static double GetWorkDensity(double amplitude, double frequency, Rule rule, double eps)
+{
+    double order = GetErrorOrder(rule);
+    return std::pow(amplitude * std::pow(frequency, order) / eps, 1 / (order + 1));
+}
+
+// Amplitude and frequency of the sample i: A is the max |f| of it and its neighbours,
+// w = sqrt(|f''| / A) by the second divided difference. NAN next to non-finite values.
+static void GetSampleForm(const std::vector<double>& x, const std::vector<double>& f, size_t i,
+                          double& amplitude, double& frequency)
+{
+    double hl = x[i] - x[i - 1];
+    double hr = x[i + 1] - x[i];
+    double d2 = 2 * ((f[i + 1] - f[i]) / hr - (f[i] - f[i - 1]) / hl) / (hl + hr);
+    amplitude = std::max({std::abs(f[i - 1]), std::abs(f[i]), std::abs(f[i + 1])});
+    frequency = amplitude > 0 ? std::sqrt(std::abs(d2) / amplitude) : 0;
+    if (!std::isfinite(amplitude) || !std::isfinite(frequency))
+        amplitude = frequency = NAN;
+}
+
+static void EvaluateSamples(const GConfig& gconf, const std::vector<double>& x, std::vector<double>& f, FilonStats& stats)
+{
+    const size_t maxCount = TasksBatchSize * MaxRulePoints;
+
+    f.resize(x.size());
+    for (size_t st = 0; st < x.size(); st += maxCount)
+        gconf.Function(x.data() + st, f.data() + st, std::min(maxCount, x.size() - st));
+    stats.Evaluations += x.size();
+}
+
+// Samples the integrand on DensitySamples equal cells of [start, stop], then halves the cells next
+// to the samples whose oscillations or curvature are not resolved, w h > 1, while there are at most
+// DensityMaxSamples samples. So chirps and peaks narrower than the coarse grid are seen.
+// Samples next to non-finite values get the max density. The density is at least one task per [start, stop].
+static DensityTable SampleWorkDensity(const GConfig& gconf, double start, double stop, FilonStats& stats)
+{
+    std::vector<double> x(DensitySamples + 1);
+    for (size_t st = 0; st <= DensitySamples; st++)
+        x[st] = st == DensitySamples ? stop : start + st * (stop - start) / DensitySamples;
+
+    std::vector<double> f;
+    EvaluateSamples(gconf, x, f, stats);
+
+    std::vector<bool> refine;
+    std::vector<double> newX;
+    std::vector<double> newF;
+    std::vector<double> mergedX;
+    std::vector<double> mergedF;
+    for (;;)
+    {
+        // Cell i is [x[i], x[i + 1]].
+        refine.assign(x.size() - 1, false);
+        for (size_t st = 1; st + 1 < x.size(); st++)
+        {
+            double amplitude = 0;
+            double frequency = 0;
+            GetSampleForm(x, f, st, amplitude, frequency);
+            if (frequency * std::max(x[st] - x[st - 1], x[st + 1] - x[st]) > 1)
+                refine[st - 1] = refine[st] = true;
+        }
+
+        newX.clear();
+        for (size_t st = 0; st + 1 < x.size(); st++)
+        {
+            double xm = (x[st] + x[st + 1]) / 2;
+            if (refine[st] && xm != x[st] && xm != x[st + 1])
+                newX.push_back(xm);
+        }
+        if (newX.empty() || x.size() + newX.size() > DensityMaxSamples)
+            break;
+
+        EvaluateSamples(gconf, newX, newF, stats);
+
+        // Merges the midpoints into the ascending samples.
+        mergedX.clear();
+        mergedF.clear();
+        size_t next = 0;
+        for (size_t st = 0; st < x.size(); st++)
+        {
+            mergedX.push_back(x[st]);
+            mergedF.push_back(f[st]);
+            if (next < newX.size() && st + 1 < x.size() && newX[next] < x[st + 1])
+            {
+                mergedX.push_back(newX[next]);
+                mergedF.push_back(newF[next]);
+                next++;
+            }
+        }
+        x.swap(mergedX);
+        f.swap(mergedF);
+    }
+
+    DensityTable table = {x, std::vector<double>(x.size())};
+    double minDensity = 1 / (stop - start);
+    double maxDensity = minDensity;
+    for (size_t st = 1; st + 1 < x.size(); st++)
+    {
+        double amplitude = 0;
+        double frequency = 0;
+        GetSampleForm(x, f, st, amplitude, frequency);
+
+        double density = std::isnan(amplitude) ? NAN : minDensity;
+        if (amplitude > 0)
+            density = std::max(minDensity, GetWorkDensity(amplitude, frequency, gconf.Rule, gconf.Eps));
+
+        table.Values[st] = density;
+        if (density > maxDensity)
+            maxDensity = density;
+    }
+    table.Values.front() = table.Values[1];
+    table.Values.back() = table.Values[x.size() - 2];
+
+    for (double& density : table.Values)
+    {
+        if (std::isnan(density))
+            density = maxDensity;
+    }
+    return table;
+}
+
+// The oscillatory form is a shortcut of the sampled density, it is exact near singularities.
+static double GetWorkDensity(const GConfig& gconf, const DensityTable& table, double x)
+{
+    if (gconf.Form)
+        return GetWorkDensity(std::abs(gconf.Form->Amplitude(x)), std::abs(gconf.Form->PhaseDerivative(x)),
+                              gconf.Rule, gconf.Eps);
+
+    // Linear interpolation of the samples, constant without them.
+    if (table.X.empty())
+        return 1;
+
+    size_t index = std::upper_bound(table.X.begin(), table.X.end(), x) - table.X.begin();
+    if (index == 0)
+        return table.Values.front();
+    if (index == table.X.size())
+        return table.Values.back();
+
+    double weight = (x - table.X[index - 1]) / (table.X[index] - table.X[index - 1]);
+    return table.Values[index - 1] * (1 - weight) + table.Values[index] * weight;
+}
+
+static double EstimateCost(const GConfig& gconf, const DensityTable& table, const Interval& interval)
+{
+    double xm = (interval.x1 + interval.x2) / 2;
+    return (GetWorkDensity(gconf, table, interval.x1) + 4 * GetWorkDensity(gconf, table, xm) +
+            GetWorkDensity(gconf, table, interval.x2)) / 6 * (interval.x2 - interval.x1);
+}
+
+struct CostPiece
+{
+    Interval Piece;
+    double Cost;
+};
+
+// Splits the interval into pieces in ascending order, whose cost estimates are converged
+// to StartCostTolerance and do not exceed maxCost.
+static void SplitByCost(const GConfig& gconf, const DensityTable& table, const Interval& interval, double maxCost,
+                        std::vector<CostPiece>& pieces)
+{
+    std::vector<CostPiece> stack = {{interval, EstimateCost(gconf, table, interval)}};
+    while (stack.size() > 0)
+    {
+        CostPiece piece = stack.back();
+        stack.pop_back();
+
+        double xm = (piece.Piece.x1 + piece.Piece.x2) / 2;
+        CostPiece left  = {{piece.Piece.x1, xm}, 0};
+        CostPiece right = {{xm, piece.Piece.x2}, 0};
+        left.Cost  = EstimateCost(gconf, table, left.Piece);
+        right.Cost = EstimateCost(gconf, table, right.Piece);
+
+        bool converged = std::abs(piece.Cost - (left.Cost + right.Cost)) <= StartCostTolerance * piece.Cost;
+        bool degenerate = xm == piece.Piece.x1 || xm == piece.Piece.x2;
+        if (degenerate || (converged && piece.Cost <= maxCost))
+        {
+            pieces.push_back(piece);
+            continue;
+        }
+
+        stack.push_back(right);
+        stack.push_back(left);
+    }
+}
+
+void SplitStartIntervals(GConfig& gconf, const IntArgs& args, size_t part, size_t partsCount,
+                         std::vector<Interval>& intervals, std::vector<Interval>& rest, FilonStats& stats)
+{
+    size_t oscillatoryCount = 0;
+    double dx = (args.StopInt - args.StartInt) / static_cast<double>(args.StartIntervalsCount);
+    for (size_t st = 0; st < args.StartIntervalsCount; st++)
+    {
+        // Neighbours share bit equal bounds.
+        double x1 = args.StartInt + st * dx;
+        double x2 = st + 1 == args.StartIntervalsCount ? args.StopInt : args.StartInt + (st + 1) * dx;
+
+        if (gconf.Oscillation &&
+            std::abs(gconf.Oscillation->Phase(x2) - gconf.Oscillation->Phase(x1)) >= FilonMinPhase)
+        {
+            if (oscillatoryCount++ % partsCount == part)
+                gconf.Result += IntegrateOscillatory(gconf, x1, x2, rest, stats);
+        }
+        else
+            intervals.push_back({x1, x2});
+    }
+}
+
+void CreateStartTasks(GConfig& gconf, std::vector<Interval> intervals, size_t part, size_t partsCount, FilonStats& stats)
+{
+    std::sort(intervals.begin(), intervals.end(),
+              [](const Interval& a, const Interval& b) { return a.x1 < b.x1; });
+
+    DensityTable table = {};
+    if (!gconf.Form && !intervals.empty() && intervals.back().x2 > intervals.front().x1)
+        table = SampleWorkDensity(gconf, intervals.front().x1, intervals.back().x2, stats);
+
+    // Estimates of coarse intervals are far off near singularities, so the total cost
+    // is taken from converged pieces first and then too costly pieces are split.
+    std::vector<CostPiece> coarsePieces;
+    for (const Interval& interval : intervals)
+        SplitByCost(gconf, table, interval, INFINITY, coarsePieces);
+
+    double totalCost = 0;
+    for (const CostPiece& piece : coarsePieces)
+        totalCost += piece.Cost;
+
+    // Every part and thread gets StartTasksPerThread tasks.
+    size_t chunksCount = partsCount * gconf.ThreadsNumber * StartTasksPerThread;
+    double chunkCost = totalCost / chunksCount;
+
+    std::vector<CostPiece> pieces;
+    for (const CostPiece& piece : coarsePieces)
+    {
+        if (piece.Cost > chunkCost)
+            SplitByCost(gconf, table, piece.Piece, chunkCost, pieces);
+        else
+            pieces.push_back(piece);
+    }
+
+    totalCost = 0;
+    for (const CostPiece& piece : pieces)
+        totalCost += piece.Cost;
+
+    // Joins neighbour pieces to tasks of chunkCost and deals them by the cost prefix:
+    // a task goes to the part and the thread its cost midpoint falls to.
+
+    double prefix = 0;
+    for (size_t st = 0; st < pieces.size(); )
+    {
+        Interval chunk = pieces[st].Piece;
+        double cost = 0;
+        do
+        {
+            chunk.x2 = pieces[st].Piece.x2;
+            cost += pieces[st].Cost;
+            st++;
+        }
+        while (st < pieces.size() && cost < chunkCost && pieces[st].Piece.x1 == chunk.x2);
+
+        double position = (prefix + cost / 2) / totalCost * partsCount;
+        prefix += cost;
+
+        size_t chunkPart = std::min(static_cast<size_t>(position), partsCount - 1);
+        if (chunkPart != part)
+            continue;
+
+        size_t thread = std::min(static_cast<size_t>((position - chunkPart) * gconf.ThreadsNumber),
+                                 gconf.ThreadsNumber - 1);
+
+        Task task =
+        {
+            .x1  = chunk.x1,
+            .x2  = chunk.x2,
+            .f1  = 0,
+            .f2  = 0,
+            .Int = 0
+        };
+        stats.Evaluations += InitTask(gconf.Rule, gconf.Function, task);
+
+        gconf.StartTasks[thread].Push(task);
+    }
+}
+
+template <Rule rule>
+static bool RestoreTasks(GConfig& gconf, PartitionReader& reader, std::deque<AcceptedSplit>& accepted)
+{
+    uint64_t count = reader.GetCount();
+    for (size_t thread = 0; thread < gconf.ThreadsNumber; thread++)
+    {
+        // Neighbour tasks go to the same thread.
+        uint64_t first = count * thread / gconf.ThreadsNumber;
+        uint64_t last = count * (thread + 1) / gconf.ThreadsNumber;
+
+        TaskStack& tasks = gconf.StartTasks[thread];
+        for (uint64_t st = first; st < last; st++)
+        {
+            AcceptedSplit split = {};
+            if (!reader.Read(split))
+                return false;
+
+            Task t1;
+            Task t2;
+            bool halves = RestoreSplit<rule>(split, t1, t2);
+
+            if (!halves || split.Error < gconf.Eps)
+            {
+                gconf.Result += halves ? GetInt<rule>(t1) + GetInt<rule>(t2) : GetInt<rule>(t1);
+                if (gconf.KeepAccepted)
+                    accepted.push_back(split);
+            }
+            else
+            {
+                tasks.Push(t1, t2);
+            }
+        }
+    }
+
+    return true;
+}
+
+static PartitionInfo GetPartitionInfo(const GConfig& gconf, const IntArgs& args)
+{
+    return PartitionInfo
+    {
+        .Rule     = gconf.Rule,
+        .StartInt = args.StartInt,
+        .StopInt  = args.StopInt,
+        .Eps      = gconf.Eps,
+        .Function = args.Function ? args.Function : ""
+    };
+}
+
+bool LoadStartTasks(GConfig& gconf, const IntArgs& args, size_t& refinedSplits)
+{
+    PartitionReader reader;
+    if (!reader.Open(args.PartitionInput))
+        return false;
+
+    const PartitionInfo& info = reader.GetInfo();
+    PartitionInfo expected = GetPartitionInfo(gconf, args);
+    if (info.Rule != expected.Rule || info.StartInt != expected.StartInt || info.StopInt != expected.StopInt ||
+        info.Function != expected.Function)
+    {
+        std::cout << "Partition of " << args.PartitionInput << " is made for other limits, rule or function." << std::endl;
+        return false;
+    }
+
+    std::deque<AcceptedSplit> accepted;
+    bool restored = false;
+    switch (gconf.Rule)
+    {
+        case Rule::Trapezoid:
+            restored = RestoreTasks<Rule::Trapezoid>(gconf, reader, accepted);
+            break;
+
+        case Rule::Simpson:
+            restored = RestoreTasks<Rule::Simpson>(gconf, reader, accepted);
+            break;
+
+        case Rule::GaussKronrod:
+            restored = RestoreTasks<Rule::GaussKronrod>(gconf, reader, accepted);
+            break;
+    }
+
+    if (!restored)
+        return false;
+
+    refinedSplits = 0;
+    for (const TaskStack& tasks : gconf.StartTasks)
+        refinedSplits += tasks.Size() / 2;
+
+    if (gconf.KeepAccepted)
+        gconf.Accepted.push_back(std::move(accepted));
+
+    return true;
+}
+
+SumAccumulator ReduceResults(const GConfig& gconf)
+{
+    std::vector<SumAccumulator> results = {gconf.Result};
+    results.insert(results.end(), gconf.ThreadResults.begin(), gconf.ThreadResults.end());
+    return ReduceTree(std::move(results));
+}
+
+bool SaveAcceptedTasks(GConfig& gconf, const IntArgs& args)
+{
+    return SavePartition(args.PartitionOutput, GetPartitionInfo(gconf, args), gconf.Accepted);
+}
+
+const char* GetRuleName(Rule rule)
+{
+    switch (rule)
+    {
+        case Rule::Trapezoid:
+            return "trapezoid";
+        case Rule::Simpson:
+            return "simpson";
+        case Rule::GaussKronrod:
+            return "gk15";
+    }
+    return "";
+}
+
+bool SaveProfiles(GConfig& gconf, const IntArgs& args, double executionTime, const std::string& suffix)
+{
+    if (!gconf.Profile)
+        return true;
+
+    RunProfile profile =
+    {
+        .Rule           = GetRuleName(gconf.Rule),
+        .Eps            = gconf.Eps,
+        .TaskPacketSize = gconf.TaskToDoPacketSize,
+        .ExecutionTime  = executionTime,
+        .Threads        = std::move(gconf.Profiles)
+    };
+
+    std::sort(profile.Threads.begin(), profile.Threads.end(),
+              [](const ThreadProfile& a, const ThreadProfile& b) { return a.Thread < b.Thread; });
+
+    if (args.ProfileOutput && !SaveProfile((args.ProfileOutput + suffix).c_str(), profile))
+        return false;
+    if (args.TraceOutput && !SaveTrace((args.TraceOutput + suffix).c_str(), profile))
+        return false;
+
+    return true;
+}
\ No newline at end of file
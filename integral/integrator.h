@@ -0,0 +1,227 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <semaphore.h>
+
+#include "../common/reduction.h"
+#include "deque.h"
+#include "filon.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "taskstack.h"
+#include "topology.h"
+
+class Expression;
+
+// Tasks whose midpoints are evaluated by one vectorized call.
+const size_t TasksBatchSize = 16;
+
+// Intervals whose phase changes by more than FilonMinPhase are integrated by the Filon rule.
+const double FilonMinPhase = 8 * M_PI;
+
+// Start tasks of equal estimated cost per thread.
+const size_t StartTasksPerThread = 4;
+
+// Relative tolerance of the cost estimates of start tasks.
+const double StartCostTolerance = 0.05;
+
+// Coarse grid intervals and max samples of the integrand for the cost model,
+// if the oscillatory form is not known.
+const size_t DensitySamples = 1024;
+const size_t DensityMaxSamples = 16384;
+
+// Quadrature rule of a task. The error of a task is estimated by comparing
+// its Int with the sum of Int of its halves.
+enum class Rule
+{
+    // Trapezoid rule, 1 new point per split.
+    Trapezoid,
+    // Simpson rule on x1, xm, x2, 3 new points per split: the split point and the midpoints of the halves.
+    // Splitting at the cached xm gives 5 equispaced points, which alias on chirps like sin(1/x)/x:
+    // when their phase step is close to 2 pi the halves agree with the whole interval and a wrong
+    // value is accepted. So the split point is off the center.
+    Simpson,
+    // 15 points Kronrod rule, 30 new points per split.
+    GaussKronrod
+};
+
+// Max new points per split.
+const size_t MaxRulePoints = 30;
+
+// Split point of Simpson tasks relative to the interval.
+const double SimpsonSplit = 0.45;
+
+// Shared deques hand over whole chunks of the private stacks.
+using TaskDeque = WorkStealingDeque<TaskChunk*>;
+
+// Accepted split of a task, kept to refine the partition later with a smaller eps.
+// The split point comes from the rule, the halves are rebuilt from fc and Slots.
+struct AcceptedSplit
+{
+    double x1;
+    double x2;
+    double f1;
+    double f2;
+    // Sample at the split point.
+    double fc;
+    // Int or fm of the halves. A task too short to split has its own slot in Slots[0].
+    double Slots[2];
+    // |Int - Int of halves|.
+    float Error;
+};
+
+// Vectorized integrand: f[i] = F(x[i]) for count <= TasksBatchSize * MaxRulePoints points.
+// Context is passed to Batch, e.g. a compiled expression.
+struct Integrand
+{
+    void (*Batch)(const void* context, const double* x, double* f, size_t count);
+    const void* Context;
+
+    void operator () (const double* x, double* f, size_t count) const
+    {
+        Batch(Context, x, f, count);
+    }
+};
+
+// Vectorized integrand of several variables: f[i] = F(x[0][i], x[1][i], ...).
+struct MultiIntegrand
+{
+    void (*Batch)(const void* context, const double* const* x, double* f, size_t count);
+    const void* Context;
+
+    void operator () (const double* const* x, double* f, size_t count) const
+    {
+        Batch(Context, x, f, count);
+    }
+};
+
+// Run of the integrator, the scheduler state is in the base, see scheduler.h.
+struct GConfig : SchedulerPool<TaskChunk*>
+{
+    std::atomic<size_t> ProcNumber;
+    size_t TaskToDoPacketSize;
+    double Eps;
+    ::Rule Rule;
+    ::Integrand Function;
+    // Compiled user integrand, Function refers to it.
+    std::shared_ptr<const Expression> UserFunction;
+    // Oscillatory form of Function if it is known, it drives the cost model of start tasks.
+    const OscillatoryIntegrand* Form;
+    // Form if oscillations are integrated by the Filon rule, nullptr if they are resolved by bisection.
+    const OscillatoryIntegrand* Oscillation;
+
+    // Results of the start tasks, e.g. of the Filon rule, and of the threads by thread index.
+    // They are merged in a tree by ReduceResults(), the mode of Result is the one of all sums.
+    SumAccumulator Result;
+    std::vector<SumAccumulator> ThreadResults;
+    size_t TotalTasksDone;
+    size_t TotalEvaluations;
+
+    // Chunks of all task stacks.
+    TaskArena Arena;
+    // Private stacks of the threads at start.
+    std::vector<TaskStack> StartTasks;
+
+    // CPUs of the threads, empty if they are not pinned. Pinned threads move their start stacks
+    // to the arena of their NUMA node and steal from the threads of their package first.
+    std::vector<CpuPlace> Places;
+    std::unique_ptr<TaskArena[]> NodeArenas;
+
+    // Accepted splits are kept to save the partition, a deque per thread.
+    bool KeepAccepted;
+    std::vector<std::deque<AcceptedSplit>> Accepted;
+
+    // Threads add their profiles if profiling is on.
+    std::vector<ThreadProfile> Profiles;
+
+    sem_t GConfAccess;
+};
+
+// Launch arguments shared by the integrators.
+struct IntArgs
+{
+    size_t ThreadsNumber;
+    double StartInt;
+    double StopInt;
+    double Eps;
+    size_t StartIntervalsCount;
+    size_t TaskPacketSize;
+    ::Rule Rule;
+    bool Filon;
+    // Expression of the integrand, nullptr for IntFunctBatch().
+    const char* Function;
+    // Partition files to refine and to save, or nullptr.
+    const char* PartitionInput;
+    const char* PartitionOutput;
+    // Scheduler profile files in JSON and the Chrome trace format, or nullptr.
+    const char* ProfileOutput;
+    const char* TraceOutput;
+    PinPolicy Pin;
+    SumMode Sum;
+};
+
+struct Interval
+{
+    double x1;
+    double x2;
+};
+
+struct FilonStats
+{
+    size_t TasksDone;
+    size_t Evaluations;
+};
+
+// Default integrand f[i] = sin(1/x[i])/x[i], vectorized.
+void IntFunctBatch(const double* x, double* f, size_t count);
+
+extern const Integrand IntIntegrand;
+
+// IntFunctBatch() as an oscillatory integrand.
+extern const OscillatoryIntegrand IntOscillation;
+
+// Parses argv[first...]. Prints the usage and returns false on errors.
+bool ParseIntArgs(int argc, char* argv[], int first, IntArgs& args);
+
+// extraDeques deques are added after the ones of the threads, their owners count as active threads.
+// Compiles the integrand, prints the error and returns false on bad ones.
+bool InitGConfig(GConfig& gconf, const IntArgs& args, size_t extraDeques);
+
+// Splits [StartInt, StopInt] into equal intervals. Oscillatory ones are dealt round robin to the parts,
+// part integrates its ones at once, adds them to gconf.Result and appends the intervals left of them
+// to rest. The other intervals are appended to intervals.
+void SplitStartIntervals(GConfig& gconf, const IntArgs& args, size_t part, size_t partsCount,
+                         std::vector<Interval>& intervals, std::vector<Interval>& rest, FilonStats& stats);
+
+// Splits the intervals into tasks of equal estimated cost and pushes the ones of part (a rank)
+// to the start stacks of its threads. The cost comes from the oscillatory form of the integrand
+// or from its samples. All parts must pass the same intervals, in any order.
+void CreateStartTasks(GConfig& gconf, std::vector<Interval> intervals, size_t part, size_t partsCount, FilonStats& stats);
+
+// Loads the partition of args.PartitionInput. Splits with errors below Eps are added
+// to gconf.Result, the halves of the other ones are dealt to StartTasks in contiguous shares.
+// Prints the problem and returns false on errors.
+bool LoadStartTasks(GConfig& gconf, const IntArgs& args, size_t& refinedSplits);
+
+// gconf.Result merged with the results of the threads in a fixed tree, it does not depend
+// on the order the threads finish in.
+SumAccumulator ReduceResults(const GConfig& gconf);
+
+// Saves gconf.Accepted to args.PartitionOutput.
+bool SaveAcceptedTasks(GConfig& gconf, const IntArgs& args);
+
+// Saves gconf.Profiles to args.ProfileOutput and args.TraceOutput if they are set,
+// suffix is added to the file names, e.g. the rank.
+bool SaveProfiles(GConfig& gconf, const IntArgs& args, double executionTime, const std::string& suffix);
+
+const char* GetRuleName(Rule rule);
+
+// Worker thread, args is GConfig.
+void* threadFunction(void* args);
\ No newline at end of file
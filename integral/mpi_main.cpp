@@ -0,0 +1,466 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <semaphore.h>
+#include <mpi.h>
+
+#include "../common/counters.h"
+#include "../common/mpi_reduction.h"
+#include "integrator.h"
+
+// Ranks run the thread scheduler of integrator.h. The main thread of a rank is the
+// communication thread: it owns the extra deque SharedTasks[ThreadsNumber], answers steal
+// requests of other ranks with tasks of the local deques, asks a random rank for tasks when
+// its threads run dry and detects the global termination with the Safra token algorithm.
+
+const int StealRequestTag = 1;
+const int TasksTag        = 2;
+const int TokenTag        = 3;
+const int TerminateTag    = 4;
+
+// Max tasks in a reply to a steal request, whole chunks are sent.
+const size_t RankStealBatch = 64;
+
+// Sleep of the communication thread when no message came.
+const std::chrono::microseconds CommPollInterval(50);
+
+struct PendingSend
+{
+    MPI_Request Request;
+    std::vector<char> Data;
+};
+
+struct RConfig
+{
+    int Rank;
+    int RanksCount;
+    GConfig* Gconf;
+    // Deque of the communication thread, chunks of received tasks are pushed to it.
+    TaskDeque* Tasks;
+    // Packs received tasks to chunks and unpacks stolen ones.
+    TaskStack Stack;
+    uint64_t RandomState;
+
+    // A steal request is sent and the reply has not come yet.
+    bool StealRequested;
+
+    // Safra algorithm: work messages sent minus received, color of the rank and the token.
+    int64_t MessageCounter;
+    bool Black;
+    bool HasToken;
+    // Rank 0 only, the token made a round.
+    bool TokenReturned;
+    int64_t TokenCounter;
+    bool TokenBlack;
+
+    bool Finished;
+
+    // Buffers of not completed MPI_Isend.
+    std::list<PendingSend> Sends;
+
+    size_t TasksSent;
+    size_t TasksReceived;
+    size_t StealRequestsSent;
+};
+
+static uint64_t NextRandom(RConfig& rconf)
+{
+    uint64_t x = rconf.RandomState;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    rconf.RandomState = x;
+    return x;
+}
+
+static void Send(RConfig& rconf, int dest, int tag, const void* data, size_t size)
+{
+    PendingSend& send = rconf.Sends.emplace_back();
+    send.Data.assign(static_cast<const char*>(data), static_cast<const char*>(data) + size);
+    MPI_Isend(send.Data.data(), size, MPI_BYTE, dest, tag, MPI_COMM_WORLD, &send.Request);
+}
+
+static void TestSends(RConfig& rconf)
+{
+    for (auto it = rconf.Sends.begin(); it != rconf.Sends.end(); )
+    {
+        int done = 0;
+        MPI_Test(&it->Request, &done, MPI_STATUS_IGNORE);
+        if (done)
+            it = rconf.Sends.erase(it);
+        else
+            it++;
+    }
+}
+
+// All threads of the rank are idle and no received task waits for them.
+static bool IsPassive(const RConfig& rconf)
+{
+    return rconf.Gconf->ActiveThreads.load() == 1 && rconf.Tasks->Size() == 0;
+}
+
+// Replies with up to a half of the chunks of every local deque.
+static void ServeStealRequest(RConfig& rconf, int source)
+{
+    GConfig& gconf = *rconf.Gconf;
+
+    std::vector<Task> tasks;
+    for (size_t st = 0; st < gconf.DequesCount && tasks.size() < RankStealBatch; st++)
+    {
+        size_t count = (gconf.SharedTasks[st].Size() + 1) / 2;
+        TaskChunk* chunk = nullptr;
+        for (size_t chunkIndex = 0; chunkIndex < count && tasks.size() < RankStealBatch; chunkIndex++)
+        {
+            if (!gconf.SharedTasks[st].Steal(chunk))
+                break;
+
+            rconf.Stack.PushChunk(chunk);
+            size_t size = tasks.size();
+            tasks.resize(size + rconf.Stack.Size());
+            rconf.Stack.Pop(tasks.data() + size, rconf.Stack.Size());
+        }
+    }
+
+    if (tasks.size() > 0)
+    {
+        rconf.MessageCounter++;
+        rconf.TasksSent += tasks.size();
+    }
+
+    Send(rconf, source, TasksTag, tasks.data(), tasks.size() * sizeof(Task));
+}
+
+static void ReceiveTasks(RConfig& rconf, const MPI_Status& status)
+{
+    int size = 0;
+    MPI_Get_count(&status, MPI_BYTE, &size);
+
+    std::vector<Task> tasks(size / sizeof(Task));
+    MPI_Recv(tasks.data(), size, MPI_BYTE, status.MPI_SOURCE, TasksTag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+    rconf.StealRequested = false;
+    if (tasks.size() == 0)
+        return;
+
+    rconf.MessageCounter--;
+    rconf.Black = true;
+    rconf.TasksReceived += tasks.size();
+
+    for (const Task& task : tasks)
+        rconf.Stack.Push(task);
+
+    while (TaskChunk* chunk = rconf.Stack.TakeBottom())
+        rconf.Tasks->Push(chunk);
+    WakeParkedThreads(*rconf.Gconf);
+}
+
+// Handles all arrived messages, returns false if there were none.
+static bool ServeMessages(RConfig& rconf)
+{
+    bool served = false;
+    while (true)
+    {
+        int flag = 0;
+        MPI_Status status = {};
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, &status);
+        if (!flag)
+            return served;
+
+        served = true;
+        switch (status.MPI_TAG)
+        {
+            case StealRequestTag:
+                MPI_Recv(nullptr, 0, MPI_BYTE, status.MPI_SOURCE, StealRequestTag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                ServeStealRequest(rconf, status.MPI_SOURCE);
+                break;
+
+            case TasksTag:
+                ReceiveTasks(rconf, status);
+                break;
+
+            case TokenTag:
+            {
+                int64_t token[2] = {};
+                MPI_Recv(token, sizeof(token), MPI_BYTE, status.MPI_SOURCE, TokenTag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                rconf.HasToken = true;
+                rconf.TokenReturned = true;
+                rconf.TokenCounter = token[0];
+                rconf.TokenBlack = token[1];
+                break;
+            }
+
+            case TerminateTag:
+                MPI_Recv(nullptr, 0, MPI_BYTE, status.MPI_SOURCE, TerminateTag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                rconf.Finished = true;
+                break;
+        }
+    }
+}
+
+static void RequestTasks(RConfig& rconf)
+{
+    if (rconf.RanksCount == 1 || rconf.StealRequested || !IsPassive(rconf))
+        return;
+
+    int victim = NextRandom(rconf) % (rconf.RanksCount - 1);
+    if (victim >= rconf.Rank)
+        victim++;
+
+    Send(rconf, victim, StealRequestTag, nullptr, 0);
+    rconf.StealRequested = true;
+    rconf.StealRequestsSent++;
+}
+
+// Safra termination detection. The token goes around the ring 0, 1, ..., RanksCount - 1
+// and sums MessageCounter of passive ranks. A rank that received tasks after passing
+// the token is black, so rank 0 starts a new round instead of terminating.
+static void PassToken(RConfig& rconf)
+{
+    if (!rconf.HasToken || !IsPassive(rconf))
+        return;
+
+    if (rconf.Rank == 0)
+    {
+        bool done = rconf.RanksCount == 1 ||
+                    (rconf.TokenReturned && !rconf.TokenBlack && !rconf.Black &&
+                     rconf.TokenCounter + rconf.MessageCounter == 0);
+        if (done)
+        {
+            for (int rank = 1; rank < rconf.RanksCount; rank++)
+                Send(rconf, rank, TerminateTag, nullptr, 0);
+            rconf.Finished = true;
+            return;
+        }
+
+        rconf.Black = false;
+        int64_t token[2] = {0, 0};
+        Send(rconf, 1, TokenTag, token, sizeof(token));
+    }
+    else
+    {
+        int64_t token[2] = {rconf.TokenCounter + rconf.MessageCounter, rconf.TokenBlack || rconf.Black};
+        rconf.Black = false;
+        Send(rconf, (rconf.Rank + 1) % rconf.RanksCount, TokenTag, token, sizeof(token));
+    }
+
+    rconf.HasToken = false;
+}
+
+// Steal requests of other ranks may still come after the termination, they get empty replies
+// until all ranks have their own requests answered.
+static void Drain(RConfig& rconf)
+{
+    MPI_Request barrier = MPI_REQUEST_NULL;
+    bool barrierStarted = false;
+
+    while (true)
+    {
+        bool served = ServeMessages(rconf);
+        TestSends(rconf);
+
+        if (!rconf.StealRequested && !barrierStarted)
+        {
+            MPI_Ibarrier(MPI_COMM_WORLD, &barrier);
+            barrierStarted = true;
+        }
+
+        if (barrierStarted)
+        {
+            int done = 0;
+            MPI_Test(&barrier, &done, MPI_STATUS_IGNORE);
+            if (done)
+                break;
+        }
+
+        if (!served)
+            std::this_thread::sleep_for(CommPollInterval);
+    }
+
+    for (PendingSend& send : rconf.Sends)
+        MPI_Wait(&send.Request, MPI_STATUS_IGNORE);
+    rconf.Sends.clear();
+}
+
+// Appends the intervals of all ranks to intervals, in rank order.
+static void GatherIntervals(const std::vector<Interval>& ranksIntervals, int procsCount, std::vector<Interval>& intervals)
+{
+    // Bounds of an interval are sent as two doubles.
+    int size = static_cast<int>(2 * ranksIntervals.size());
+    std::vector<int> sizes(procsCount);
+    MPI_Allgather(&size, 1, MPI_INT, sizes.data(), 1, MPI_INT, MPI_COMM_WORLD);
+
+    std::vector<int> offsets(procsCount);
+    int totalSize = 0;
+    for (int st = 0; st < procsCount; st++)
+    {
+        offsets[st] = totalSize;
+        totalSize += sizes[st];
+    }
+
+    std::vector<Interval> gathered(totalSize / 2);
+    MPI_Allgatherv(ranksIntervals.data(), size, MPI_DOUBLE, gathered.data(), sizes.data(), offsets.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+    intervals.insert(intervals.end(), gathered.begin(), gathered.end());
+}
+
+int main(int argc, char* argv[])
+{
+    int provided = 0;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+    double startTime = MPI_Wtime();
+
+    int procRank = 0;
+    int procsCount = 0;
+    MPI_Comm_size(MPI_COMM_WORLD, &procsCount);
+    MPI_Comm_rank(MPI_COMM_WORLD, &procRank);
+
+    IntArgs args = {};
+    if (!ParseIntArgs(argc, argv, 1, args))
+    {
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    size_t threadsNumber = args.ThreadsNumber;
+
+    // The communication thread owns one deque and stays active until the global termination.
+    GConfig gconf = {};
+    if (!InitGConfig(gconf, args, 1) || args.PartitionInput || args.PartitionOutput)
+    {
+        if (args.PartitionInput || args.PartitionOutput)
+            std::cout << "Partition files are supported by int only." << std::endl;
+        MPI_Finalize();
+        return EXIT_FAILURE;
+    }
+
+    FilonStats filonStats = {};
+    std::vector<Interval> intervals;
+    std::vector<Interval> rest;
+    SplitStartIntervals(gconf, args, procRank, procsCount, intervals, rest, filonStats);
+    GatherIntervals(rest, procsCount, intervals);
+    CreateStartTasks(gconf, std::move(intervals), procRank, procsCount, filonStats);
+
+    gconf.TotalTasksDone += filonStats.TasksDone;
+    gconf.TotalEvaluations += filonStats.Evaluations;
+
+    RConfig rconf = {};
+    rconf.Rank = procRank;
+    rconf.RanksCount = procsCount;
+    rconf.Gconf = &gconf;
+    rconf.Tasks = &gconf.SharedTasks[threadsNumber];
+    rconf.Stack = TaskStack(gconf.Arena);
+    rconf.RandomState = 0x9E3779B97F4A7C15ull * (procRank + 1);
+    rconf.HasToken = procRank == 0;
+
+    std::vector<pthread_t> threads(threadsNumber);
+
+    // Other ranks wait for this one in the termination protocol, so failures abort all of them.
+    if (sem_init(&gconf.GConfAccess, 0, 1))
+    {
+        std::cout << "RANK[" << procRank << "] failed to init the semaphore." << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t st = 0; st < threadsNumber; st++)
+    {
+        if (pthread_create(&threads[st], nullptr, threadFunction, &gconf))
+        {
+            std::cout << "RANK[" << procRank << "] failed to create THREAD[" << st << "]." << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            return EXIT_FAILURE;
+        }
+    }
+
+    while (!rconf.Finished)
+    {
+        bool served = ServeMessages(rconf);
+        RequestTasks(rconf);
+        PassToken(rconf);
+        TestSends(rconf);
+
+        if (!served)
+            std::this_thread::sleep_for(CommPollInterval);
+    }
+
+    // The threads see no active ones and exit.
+    LeaveActiveThreads(gconf);
+
+    for (size_t st = 0; st < threadsNumber; st++)
+    {
+        if (pthread_join(threads[st], nullptr))
+        {
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            return EXIT_FAILURE;
+        }
+    }
+
+    sem_destroy(&gconf.GConfAccess);
+
+    Drain(rconf);
+
+    // Profiles of the ranks go to FILE.RANK.
+    double rankTime = (MPI_Wtime() - startTime) * 1000;
+    if (!SaveProfiles(gconf, args, rankTime, "." + std::to_string(procRank)))
+    {
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        return EXIT_FAILURE;
+    }
+
+    PrintCounters("RANK[" + std::to_string(procRank) + "]");
+
+    std::cout << "RANK[" << procRank << "]:\n"
+              << "\tTasks done      = " << gconf.TotalTasksDone << "\n"
+              << "\tTasks sent      = " << rconf.TasksSent << "\n"
+              << "\tTasks received  = " << rconf.TasksReceived << "\n"
+              << "\tSteal requests  = " << rconf.StealRequestsSent << "\n"
+              << std::endl;
+
+    // Results of the threads and then of the ranks are merged in fixed trees by index.
+    SumAccumulator result = ReduceResults(gconf);
+    uint64_t counts[2] = {gconf.TotalTasksDone, gconf.TotalEvaluations};
+    uint64_t totalCounts[2] = {};
+    CollectSum(result, 0, MPI_COMM_WORLD);
+    MPI_Reduce(counts, totalCounts, 2, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (procRank == 0)
+    {
+        double execTime = (MPI_Wtime() - startTime) * 1000;
+
+        std::cout << std::setprecision(12);
+        std::cout << "MAIN RANK:\n"
+                  << "\tRanks count    = " << procsCount << "\n"
+                  << "\tTasks done     = " << totalCounts[0] << "\n"
+                  << "\tEvaluations    = " << totalCounts[1] << "\n"
+                  << "\tResult         = " << result.Get() << "\n"
+                  << "\tSummation      = " << GetSumModeName(args.Sum) << "\n"
+                  << "\tExecution time = " << execTime << " ms\n"
+                  << std::endl;
+
+        RunMetrics metrics;
+        metrics
+            .Add("time", execTime / 1000)
+            .Add("procs", procsCount)
+            .Add("threads", threadsNumber)
+            .Add("tasks", totalCounts[0])
+            .Add("evaluations", totalCounts[1]);
+        AddCounterMetrics(metrics);
+        metrics.Save();
+
+        std::ofstream file;
+        file.open("log.txt", std::ios::out | std::ios::trunc);
+        file << "Execution time = " << execTime << " ms" << std::endl;
+        file.close();
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "partition.h"
+
+const char PartitionMagic[8] = {'I', 'N', 'T', 'P', 'A', 'R', 'T', '1'};
+
+// Records written or read at once.
+const size_t PartitionBufferRecords = 1 << 16;
+
+struct PartitionHeader
+{
+    char Magic[8];
+    uint32_t Rule;
+    uint32_t FunctionLength;
+    double StartInt;
+    double StopInt;
+    double Eps;
+    uint64_t Count;
+    // Start of the first split.
+    double x1;
+    double f1;
+};
+
+// Gauss-Kronrod halves keep their integrals only, so their samples are not stored.
+static bool HasSamples(Rule rule)
+{
+    return rule != Rule::GaussKronrod;
+}
+
+static size_t GetStoredSlots(Rule rule)
+{
+    return rule == Rule::Trapezoid ? 0 : 2;
+}
+
+static size_t GetRecordSize(Rule rule)
+{
+    return sizeof(double) * (1 + (HasSamples(rule) ? 2 : 0) + GetStoredSlots(rule)) + sizeof(float);
+}
+
+template <typename T>
+static char* Put(char* data, T value)
+{
+    memcpy(data, &value, sizeof(T));
+    return data + sizeof(T);
+}
+
+template <typename T>
+static const char* Get(const char* data, T& value)
+{
+    memcpy(&value, data, sizeof(T));
+    return data + sizeof(T);
+}
+
+bool SavePartition(const char* fileName, const PartitionInfo& info, std::vector<std::deque<AcceptedSplit>>& parts)
+{
+    bool forward = info.StartInt <= info.StopInt;
+    auto precedes = [forward](const AcceptedSplit& a, const AcceptedSplit& b) { return (a.x1 < b.x1) == forward; };
+
+    size_t splitsCount = 0;
+    for (std::deque<AcceptedSplit>& part : parts)
+    {
+        std::sort(part.begin(), part.end(), precedes);
+        splitsCount += part.size();
+    }
+
+    // Heads of the parts, merged while written.
+    std::vector<size_t> heads(parts.size());
+    auto next = [&]() -> const AcceptedSplit*
+    {
+        const AcceptedSplit* split = nullptr;
+        size_t best = 0;
+        for (size_t st = 0; st < parts.size(); st++)
+        {
+            if (heads[st] < parts[st].size() && (!split || precedes(parts[st][heads[st]], *split)))
+            {
+                split = &parts[st][heads[st]];
+                best = st;
+            }
+        }
+        if (split)
+            heads[best]++;
+        return split;
+    };
+
+    std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Can not open " << fileName << "." << std::endl;
+        return false;
+    }
+
+    PartitionHeader header = {};
+    memcpy(header.Magic, PartitionMagic, sizeof(PartitionMagic));
+    header.Rule = static_cast<uint32_t>(info.Rule);
+    header.FunctionLength = info.Function.size();
+    header.StartInt = info.StartInt;
+    header.StopInt = info.StopInt;
+    header.Eps = info.Eps;
+    header.Count = splitsCount;
+
+    const AcceptedSplit* split = next();
+    header.x1 = split ? split->x1 : info.StartInt;
+    header.f1 = split ? split->f1 : 0;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(info.Function.data(), info.Function.size());
+
+    bool samples = HasSamples(info.Rule);
+    size_t slots = GetStoredSlots(info.Rule);
+    std::vector<char> buffer(PartitionBufferRecords * GetRecordSize(info.Rule));
+    while (split)
+    {
+        char* data = buffer.data();
+        for (size_t st = 0; st < PartitionBufferRecords && split; st++)
+        {
+            data = Put(data, split->x2);
+            if (samples)
+            {
+                data = Put(data, split->f2);
+                data = Put(data, split->fc);
+            }
+            for (size_t slot = 0; slot < slots; slot++)
+                data = Put(data, split->Slots[slot]);
+            data = Put(data, split->Error);
+
+            // Neighbours share bounds and samples, the ones of the first split are in the header.
+            const AcceptedSplit* previous = split;
+            split = next();
+            if (split && (split->x1 != previous->x2 || (samples && split->f1 != previous->f2)))
+            {
+                std::cout << "Partition is not contiguous at " << split->x1 << ", it is not saved." << std::endl;
+                file.close();
+                std::remove(fileName);
+                return false;
+            }
+        }
+        file.write(buffer.data(), data - buffer.data());
+    }
+
+    if (!file)
+    {
+        std::cout << "Can not write " << fileName << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool PartitionReader::Open(const char* fileName)
+{
+    File.open(fileName, std::ios::in | std::ios::binary);
+    if (!File)
+    {
+        std::cout << "Can not open " << fileName << "." << std::endl;
+        return false;
+    }
+
+    PartitionHeader header = {};
+    File.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!File || memcmp(header.Magic, PartitionMagic, sizeof(PartitionMagic)) != 0 ||
+        header.Rule > static_cast<uint32_t>(Rule::GaussKronrod))
+    {
+        std::cout << fileName << " is not a partition file." << std::endl;
+        return false;
+    }
+
+    Info.Rule = static_cast<Rule>(header.Rule);
+    Info.StartInt = header.StartInt;
+    Info.StopInt = header.StopInt;
+    Info.Eps = header.Eps;
+    Info.Function.resize(header.FunctionLength);
+    File.read(Info.Function.data(), header.FunctionLength);
+
+    Count = header.Count;
+    ReadCount = 0;
+    Buffer.resize(PartitionBufferRecords * GetRecordSize(Info.Rule));
+    BufferPosition = 0;
+    BufferSize = 0;
+    x1 = header.x1;
+    f1 = header.f1;
+
+    if (!File)
+    {
+        std::cout << fileName << " is truncated." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool PartitionReader::Read(AcceptedSplit& split)
+{
+    if (ReadCount == Count)
+        return false;
+
+    size_t recordSize = GetRecordSize(Info.Rule);
+    if (BufferPosition == BufferSize)
+    {
+        size_t count = std::min<uint64_t>(PartitionBufferRecords, Count - ReadCount);
+        File.read(Buffer.data(), count * recordSize);
+        if (!File)
+        {
+            std::cout << "Partition file is truncated." << std::endl;
+            return false;
+        }
+        BufferPosition = 0;
+        BufferSize = count * recordSize;
+    }
+
+    const char* data = Buffer.data() + BufferPosition;
+    BufferPosition += recordSize;
+    ReadCount++;
+
+    split = {};
+    split.x1 = x1;
+    split.f1 = f1;
+    data = Get(data, split.x2);
+    if (HasSamples(Info.Rule))
+    {
+        data = Get(data, split.f2);
+        data = Get(data, split.fc);
+    }
+    for (size_t slot = 0; slot < GetStoredSlots(Info.Rule); slot++)
+        data = Get(data, split.Slots[slot]);
+    data = Get(data, split.Error);
+
+    x1 = split.x2;
+    f1 = split.f2;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "integrator.h"
+
+struct PartitionInfo
+{
+    ::Rule Rule;
+    double StartInt;
+    double StopInt;
+    double Eps;
+    // Expression of the integrand, empty for IntFunctBatch().
+    std::string Function;
+};
+
+// Partition file: the info, then accepted splits in order along [StartInt, StopInt].
+// Neighbours share bounds and samples, so a record keeps x2, f2, fc, the slots the rule
+// can not recompute and the error as float: 28 bytes for trapezoid and gk15, which needs
+// no samples, and 44 bytes for simpson.
+// Functions print the problem and return false on errors.
+
+// Splits are saved from several parts, e.g. of the threads, the parts are sorted.
+bool SavePartition(const char* fileName, const PartitionInfo& info, std::vector<std::deque<AcceptedSplit>>& parts);
+
+// Reads splits one by one, so they are not held in memory together.
+class PartitionReader
+{
+private:
+    std::ifstream File;
+    PartitionInfo Info;
+    uint64_t Count;
+    uint64_t ReadCount;
+
+    std::vector<char> Buffer;
+    size_t BufferPosition;
+    size_t BufferSize;
+
+    // Bounds and samples of the next split.
+    double x1;
+    double f1;
+
+public:
+    bool Open(const char* fileName);
+
+    const PartitionInfo& GetInfo() const
+    {
+        return Info;
+    }
+
+    uint64_t GetCount() const
+    {
+        return Count;
+    }
+
+    // Next of GetCount() splits.
+    bool Read(AcceptedSplit& split);
+};
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "profile.h"
+
+static const char* GetSpanName(SpanKind kind)
+{
+    switch (kind)
+    {
+        case SpanKind::Work:
+            return "Work";
+        case SpanKind::Steal:
+            return "Steal";
+        case SpanKind::Park:
+            return "Park";
+    }
+    return "";
+}
+
+static bool OpenProfileFile(const char* fileName, std::ofstream& file)
+{
+    file.open(fileName, std::ios::out | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Can not open " << fileName << "." << std::endl;
+        return false;
+    }
+
+    file << std::setprecision(9);
+    return true;
+}
+
+static bool CloseProfileFile(const char* fileName, std::ofstream& file)
+{
+    file.close();
+    if (!file)
+    {
+        std::cout << "Can not write " << fileName << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SaveProfile(const char* fileName, const RunProfile& profile)
+{
+    std::ofstream file;
+    if (!OpenProfileFile(fileName, file))
+        return false;
+
+    file << "{\n"
+         << "  \"Rule\": \"" << profile.Rule << "\",\n"
+         << "  \"Eps\": " << profile.Eps << ",\n"
+         << "  \"TaskPacketSize\": " << profile.TaskPacketSize << ",\n"
+         << "  \"ExecutionTime\": " << profile.ExecutionTime << ",\n"
+         << "  \"Threads\": [";
+
+    for (size_t st = 0; st < profile.Threads.size(); st++)
+    {
+        const ThreadProfile& thread = profile.Threads[st];
+
+        file << (st == 0 ? "\n" : ",\n")
+             << "    {\n"
+             << "      \"Thread\": " << thread.Thread << ",\n"
+             << "      \"TasksDone\": " << thread.TasksDone << ",\n"
+             << "      \"Evaluations\": " << thread.Evaluations << ",\n"
+             << "      \"MaxTasksCount\": " << thread.MaxTasksCount << ",\n"
+             << "      \"TasksShared\": " << thread.TasksShared << ",\n"
+             << "      \"TasksTakenBack\": " << thread.TasksTakenBack << ",\n"
+             << "      \"TasksStolen\": " << thread.TasksStolen << ",\n"
+             << "      \"StealAttempts\": " << thread.StealAttempts << ",\n"
+             << "      \"FailedSteals\": " << thread.FailedSteals << ",\n"
+             << "      \"Parks\": " << thread.Parks << ",\n"
+             << "      \"WorkTime\": " << thread.WorkTime << ",\n"
+             << "      \"StealTime\": " << thread.StealTime << ",\n"
+             << "      \"ParkTime\": " << thread.ParkTime << ",\n"
+             << "      \"LockWaitTime\": " << thread.LockWaitTime << ",\n"
+             << "      \"Depth\": [";
+
+        // [Time, PrivateTasks, SharedChunks, TasksDone].
+        for (size_t sample = 0; sample < thread.Depth.size(); sample++)
+        {
+            const DepthSample& depth = thread.Depth[sample];
+            file << (sample == 0 ? "" : ", ") << "[" << depth.Time << ", " << depth.PrivateTasks << ", "
+                 << depth.SharedChunks << ", " << depth.TasksDone << "]";
+        }
+
+        file << "]\n"
+             << "    }";
+    }
+
+    file << "\n  ]\n"
+         << "}" << std::endl;
+
+    return CloseProfileFile(fileName, file);
+}
+
+bool SaveTrace(const char* fileName, const RunProfile& profile)
+{
+    std::ofstream file;
+    if (!OpenProfileFile(fileName, file))
+        return false;
+
+    // Times of the trace are in us.
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+    bool first = true;
+    auto next = [&]() -> std::ofstream&
+    {
+        file << (first ? "  " : ",\n  ");
+        first = false;
+        return file;
+    };
+
+    for (const ThreadProfile& thread : profile.Threads)
+    {
+        next() << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << thread.Thread
+               << ", \"args\": {\"name\": \"THREAD[" << thread.Thread << "]\"}}";
+
+        for (const ThreadSpan& span : thread.Spans)
+        {
+            next() << "{\"name\": \"" << GetSpanName(span.Kind) << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << thread.Thread
+                   << ", \"ts\": " << span.Start * 1000 << ", \"dur\": " << (span.Stop - span.Start) * 1000 << "}";
+        }
+
+        for (const DepthSample& depth : thread.Depth)
+        {
+            next() << "{\"name\": \"Depth[" << thread.Thread << "]\", \"ph\": \"C\", \"pid\": 0, \"tid\": " << thread.Thread
+                   << ", \"ts\": " << depth.Time * 1000 << ", \"args\": {\"PrivateTasks\": " << depth.PrivateTasks
+                   << ", \"SharedChunks\": " << depth.SharedChunks << "}}";
+        }
+    }
+
+    file << "\n]}" << std::endl;
+
+    return CloseProfileFile(fileName, file);
+}
\ No newline at end of file
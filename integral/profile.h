@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Min time between queue depth samples of a thread, ms.
+const double ProfileSampleInterval = 1;
+
+using ProfileClock = std::chrono::steady_clock;
+
+enum class SpanKind
+{
+    // Doing own tasks.
+    Work,
+    // Looking for tasks of other threads.
+    Steal,
+    // Sleeping until tasks are shared.
+    Park
+};
+
+// Times are in ms since the start of the run.
+struct ThreadSpan
+{
+    SpanKind Kind;
+    double Start;
+    double Stop;
+};
+
+struct DepthSample
+{
+    double Time;
+    // Tasks of the private stack and chunks of the shared deque.
+    uint32_t PrivateTasks;
+    uint32_t SharedChunks;
+    // Tasks done by the thread so far, their rate shows slowdowns by memory bandwidth.
+    uint64_t TasksDone;
+};
+
+// Scheduler counters of a thread. Counters are always kept, times, spans and
+// samples only if profiling is on.
+struct ThreadProfile
+{
+    size_t Thread;
+    size_t TasksDone;
+    size_t Evaluations;
+    size_t MaxTasksCount;
+    // Moved to the own shared deque, taken back from it and stolen from other threads.
+    size_t TasksShared;
+    size_t TasksTakenBack;
+    size_t TasksStolen;
+    // Steals of chunks of non-empty deques and the ones lost to other thieves or the owner.
+    size_t StealAttempts;
+    size_t FailedSteals;
+    size_t Parks;
+
+    double WorkTime;
+    double StealTime;
+    double ParkTime;
+    // Waits for the locks of the chunk arena and of the results.
+    double LockWaitTime;
+
+    std::vector<ThreadSpan> Spans;
+    std::vector<DepthSample> Depth;
+};
+
+struct RunProfile
+{
+    const char* Rule;
+    double Eps;
+    size_t TaskPacketSize;
+    double ExecutionTime;
+    std::vector<ThreadProfile> Threads;
+};
+
+// ms since start.
+inline double GetProfileTime(ProfileClock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(ProfileClock::now() - start).count();
+}
+
+// Both functions print the problem and return false on errors.
+
+// Counters, times and queue depth timelines of the threads.
+bool SaveProfile(const char* fileName, const RunProfile& profile);
+
+// Spans and queue depths in the Chrome trace event format, for chrome://tracing or Perfetto.
+bool SaveTrace(const char* fileName, const RunProfile& profile);
\ No newline at end of file
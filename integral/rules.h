@@ -0,0 +1,351 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "integrator.h"
+
+// Quadrature rules of tasks, shared by the integrators and the engine.
+
+inline void ComputeIntTrapezoid(Task& task)
+{
+    task.Int = (task.f2 + task.f1)/2 * (task.x2 - task.x1);
+}
+
+inline double GetIntSimpson(const Task& task)
+{
+    return (task.f1 + 4 * task.fm + task.f2)/6 * (task.x2 - task.x1);
+}
+
+namespace Kronrod
+{
+    // Abscissae of the 15 points Kronrod rule on [-1, 1], x[1], x[3], x[5] and 0 are the 7 points Gauss ones.
+    const double X[7] =
+    {
+        0.991455371120812639206854697526329,
+        0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926,
+        0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013,
+        0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245
+    };
+
+    const double W[7] =
+    {
+        0.022935322010529224963732008058970,
+        0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518,
+        0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550,
+        0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649
+    };
+
+    const double WCenter = 0.209482141084727828012999174891714;
+
+    const size_t Points = 15;
+
+    // Points of [x1, x2]: X[i] mirrored to the left, the center, X[i] mirrored to the right.
+    inline void GetPoints(double x1, double x2, double* x)
+    {
+        double center = (x1 + x2) / 2;
+        double halfLength = (x2 - x1) / 2;
+        for (size_t st = 0; st < 7; st++)
+        {
+            x[st]      = center - halfLength * X[st];
+            x[14 - st] = center + halfLength * X[st];
+        }
+        x[7] = center;
+    }
+
+    inline double Compute(double x1, double x2, const double* f)
+    {
+        double sum = WCenter * f[7];
+        for (size_t st = 0; st < 7; st++)
+            sum += W[st] * (f[st] + f[14 - st]);
+        return sum * (x2 - x1) / 2;
+    }
+}
+
+template <Rule rule>
+constexpr size_t GetRulePoints()
+{
+    switch (rule)
+    {
+        case Rule::Trapezoid:
+            return 1;
+        case Rule::Simpson:
+            return 3;
+        case Rule::GaussKronrod:
+            return 2 * Kronrod::Points;
+    }
+    return 0;
+}
+
+template <Rule rule>
+double GetInt(const Task& task)
+{
+    if (rule == Rule::Simpson)
+        return GetIntSimpson(task);
+    else
+        return task.Int;
+}
+
+template <Rule rule>
+double GetSplitPoint(const Task& task)
+{
+    if (rule == Rule::Simpson)
+        return task.x1 + SimpsonSplit * (task.x2 - task.x1);
+    else
+        return (task.x2 + task.x1) / 2;
+}
+
+// New points needed to split the task into halves at xc.
+template <Rule rule>
+void GetSplitPoints(const Task& task, double xc, double* x)
+{
+    switch (rule)
+    {
+        case Rule::Trapezoid:
+            x[0] = xc;
+            break;
+
+        case Rule::Simpson:
+            x[0] = xc;
+            x[1] = (task.x1 + xc) / 2;
+            x[2] = (xc + task.x2) / 2;
+            break;
+
+        case Rule::GaussKronrod:
+            Kronrod::GetPoints(task.x1, xc, x);
+            Kronrod::GetPoints(xc, task.x2, x + Kronrod::Points);
+            break;
+    }
+}
+
+// Halves of the task from the values at the split points. Cached samples are passed on.
+template <Rule rule>
+void SplitTask(const Task& task, double xc, const double* f, Task& t1, Task& t2)
+{
+    t1 = Task
+    {
+        .x1  = task.x1,
+        .x2  = xc,
+        .f1  = task.f1,
+        .f2  = 0,
+        .Int = 0
+    };
+
+    t2 = Task
+    {
+        .x1  = xc,
+        .x2  = task.x2,
+        .f1  = 0,
+        .f2  = task.f2,
+        .Int = 0
+    };
+
+    switch (rule)
+    {
+        case Rule::Trapezoid:
+            t1.f2 = f[0];
+            t2.f1 = f[0];
+            ComputeIntTrapezoid(t1);
+            ComputeIntTrapezoid(t2);
+            break;
+
+        case Rule::Simpson:
+            t1.f2 = f[0];
+            t2.f1 = f[0];
+            t1.fm = f[1];
+            t2.fm = f[2];
+            break;
+
+        case Rule::GaussKronrod:
+            t1.Int = Kronrod::Compute(t1.x1, t1.x2, f);
+            t2.Int = Kronrod::Compute(t2.x1, t2.x2, f + Kronrod::Points);
+            break;
+    }
+}
+
+// Computes Int of a task with x1 and x2 set, evaluating the function on the way.
+// Returns the number of evaluations.
+inline size_t InitTask(Rule rule, const Integrand& function, Task& task)
+{
+    double x[Kronrod::Points + 2] = {task.x1, task.x2};
+    double f[Kronrod::Points + 2] = {};
+    size_t count = 2;
+
+    switch (rule)
+    {
+        case Rule::Trapezoid:
+            break;
+
+        case Rule::Simpson:
+            x[count++] = (task.x1 + task.x2) / 2;
+            break;
+
+        case Rule::GaussKronrod:
+            Kronrod::GetPoints(task.x1, task.x2, x + count);
+            count += Kronrod::Points;
+            break;
+    }
+
+    function(x, f, count);
+    task.f1 = f[0];
+    task.f2 = f[1];
+
+    switch (rule)
+    {
+        case Rule::Trapezoid:
+            ComputeIntTrapezoid(task);
+            break;
+
+        case Rule::Simpson:
+            task.fm = f[2];
+            break;
+
+        case Rule::GaussKronrod:
+            task.Int = Kronrod::Compute(task.x1, task.x2, f + 2);
+            break;
+    }
+
+    return count;
+}
+
+inline size_t GetRulePoints(Rule rule)
+{
+    switch (rule)
+    {
+        case Rule::Trapezoid:
+            return GetRulePoints<Rule::Trapezoid>();
+        case Rule::Simpson:
+            return GetRulePoints<Rule::Simpson>();
+        case Rule::GaussKronrod:
+            return GetRulePoints<Rule::GaussKronrod>();
+    }
+    return 0;
+}
+
+inline void PushSplit(VectorStack<Task>& tasks, const Task& t1, const Task& t2)
+{
+    tasks.Push(t1);
+    tasks.Push(t2);
+}
+
+// Evaluates the new points of count tasks by one call of function, then accepts or subdivides
+// every task. Accepted integrals are added to result, a double or a SumAccumulator, and halves are
+// pushed to tasks by PushSplit(). Accepted splits are kept in accepted if it is set.
+// Returns the number of checked tasks.
+template <Rule rule, typename Stack, typename Sum>
+size_t DoBatch(const Task* batch, size_t count, const Integrand& function, double eps, Stack& tasks, Sum& result,
+               std::deque<AcceptedSplit>* accepted = nullptr)
+{
+    const size_t rulePoints = GetRulePoints<rule>();
+
+    double xc[TasksBatchSize];
+    double x[TasksBatchSize * rulePoints];
+    double f[TasksBatchSize * rulePoints];
+
+    for (size_t st = 0; st < count; st++)
+    {
+        xc[st] = GetSplitPoint<rule>(batch[st]);
+        GetSplitPoints<rule>(batch[st], xc[st], x + st * rulePoints);
+    }
+
+    function(x, f, count * rulePoints);
+
+    size_t tasksDone = 0;
+    for (size_t st = 0; st < count; st++)
+    {
+        const Task& task = batch[st];
+
+        if (xc[st] == task.x2 || xc[st] == task.x1)
+        {
+            result += GetInt<rule>(task);
+            if (accepted)
+                accepted->push_back({task.x1, task.x2, task.f1, task.f2, 0, {task.Int, 0}, 0});
+            continue;
+        }
+
+        Task t1;
+        Task t2;
+        SplitTask<rule>(task, xc[st], f + st * rulePoints, t1, t2);
+
+        double Ih = GetInt<rule>(task);
+        double Ih2 = GetInt<rule>(t1) + GetInt<rule>(t2);
+
+        tasksDone++;
+
+        if (std::abs(Ih - Ih2) < eps)
+        {
+            // Good precise.
+            result += Ih2;
+            if (accepted)
+            {
+                accepted->push_back({task.x1, task.x2, task.f1, task.f2, t1.f2, {t1.Int, t2.Int},
+                                     static_cast<float>(std::abs(Ih - Ih2))});
+            }
+        }
+        else
+        {
+            // Not enough precise.
+            PushSplit(tasks, t1, t2);
+        }
+    }
+
+    return tasksDone;
+}
+
+// Halves of an accepted split. Returns false and the task in t1 if it was too short to split.
+template <Rule rule>
+bool RestoreSplit(const AcceptedSplit& split, Task& t1, Task& t2)
+{
+    Task task =
+    {
+        .x1  = split.x1,
+        .x2  = split.x2,
+        .f1  = split.f1,
+        .f2  = split.f2,
+        .Int = split.Slots[0]
+    };
+
+    double xc = GetSplitPoint<rule>(task);
+    if (xc == task.x2 || xc == task.x1)
+    {
+        t1 = task;
+        if (rule == Rule::Trapezoid)
+            ComputeIntTrapezoid(t1);
+        return false;
+    }
+
+    t1 = Task
+    {
+        .x1  = task.x1,
+        .x2  = xc,
+        .f1  = task.f1,
+        .f2  = split.fc,
+        .Int = split.Slots[0]
+    };
+
+    t2 = Task
+    {
+        .x1  = xc,
+        .x2  = task.x2,
+        .f1  = split.fc,
+        .f2  = task.f2,
+        .Int = split.Slots[1]
+    };
+
+    // Trapezoid slots are not stored.
+    if (rule == Rule::Trapezoid)
+    {
+        ComputeIntTrapezoid(t1);
+        ComputeIntTrapezoid(t2);
+    }
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <sched.h>
+
+#include "deque.h"
+#include "profile.h"
+
+// Steal rounds over all victims before an idle thread parks.
+const size_t StealSpinRounds = 64;
+
+const bool DEBUG = false;
+
+// Shared state of the threads of a scheduler. Item is the unit of the shared deques, e.g. a chunk of tasks.
+template <typename Item>
+struct SchedulerPool
+{
+    size_t ThreadsNumber;
+    // ThreadsNumber deques of the threads and ones of other producers, e.g. of the MPI layer.
+    size_t DequesCount;
+
+    // Threads that have tasks or are stealing. Work is over when it drops to zero:
+    // a thread leaves only with an empty deque and thieves enter before stealing.
+    // Other producers count as active threads while they may add tasks.
+    std::atomic<size_t> ActiveThreads;
+
+    // Parked threads wait for a change of WorkSignal. It is bumped when tasks are shared
+    // and on termination, the wake up syscall is made only if ParkedThreads != 0.
+    std::atomic<uint32_t> WorkSignal;
+    std::atomic<size_t> ParkedThreads;
+
+    // Threads keep spans and queue depths if profiling is on, times are counted from StartTime.
+    bool Profile;
+    ProfileClock::time_point StartTime;
+
+    // Shared deque of thread i, then the deques of other producers.
+    std::unique_ptr<WorkStealingDeque<Item>[]> SharedTasks;
+};
+
+template <typename Stack, typename Item>
+struct SchedulerThread
+{
+    // Private LIFO stack. The oldest tasks are moved to SharedTasks when it runs empty,
+    // so only those go through the atomics of the deque.
+    Stack Tasks;
+    WorkStealingDeque<Item>* SharedTasks;
+    size_t ProcNumber;
+    ThreadProfile Profile;
+    // Victim selection state (xorshift).
+    uint64_t RandomState;
+    // Threads of the same package if the threads are pinned.
+    std::vector<size_t> Neighbours;
+};
+
+// Private LIFO stack of single tasks. The oldest tasks are taken from the bottom by an index,
+// their space is reclaimed when it is the larger part of the vector.
+template <typename T>
+class VectorStack
+{
+private:
+    std::vector<T> Items;
+    size_t Bottom = 0;
+
+public:
+    size_t Size() const
+    {
+        return Items.size() - Bottom;
+    }
+
+    void Push(const T& item)
+    {
+        Items.push_back(item);
+    }
+
+    // Pops min(count, Size()) items, items[0] is the deepest one. Returns the number of items.
+    size_t Pop(T* items, size_t count)
+    {
+        count = std::min(count, Size());
+        std::copy(Items.end() - count, Items.end(), items);
+        Items.resize(Items.size() - count);
+
+        if (Size() == 0)
+        {
+            Items.clear();
+            Bottom = 0;
+        }
+        return count;
+    }
+
+    // Removes the oldest item, false if the stack has less than 2 items.
+    bool TakeOldest(T& item)
+    {
+        if (Size() < 2)
+            return false;
+
+        item = Items[Bottom++];
+        if (2 * Bottom >= Items.size())
+        {
+            Items.erase(Items.begin(), Items.begin() + Bottom);
+            Bottom = 0;
+        }
+        return true;
+    }
+};
+
+template <typename Item>
+void WakeParkedThreads(SchedulerPool<Item>& pool)
+{
+    pool.WorkSignal.fetch_add(1);
+    if (pool.ParkedThreads.load() != 0)
+        pool.WorkSignal.notify_all();
+}
+
+template <typename Item>
+void LeaveActiveThreads(SchedulerPool<Item>& pool)
+{
+    // The last active thread wakes everybody to exit.
+    if (pool.ActiveThreads.fetch_sub(1) == 1)
+        WakeParkedThreads(pool);
+}
+
+template <typename Item>
+bool HasSharedTasks(const SchedulerPool<Item>& pool)
+{
+    for (size_t st = 0; st < pool.DequesCount; st++)
+    {
+        if (pool.SharedTasks[st].Size() != 0)
+            return true;
+    }
+    return false;
+}
+
+// Work stealing loop of the threads. A thread does packets of its private tasks, moves the oldest
+// ones to its shared deque when thieves have emptied it and steals the oldest items of other
+// threads when it runs dry. Policy gives the types and the operations on the private stack:
+//     Item, Thread and Pool, the last two derived from SchedulerThread and SchedulerPool;
+//     size_t GetTasksCount(const Thread&) and size_t GetTasksCount(const Item&);
+//     bool TakeOldest(Thread&, Item&), false if the stack has less than 2 tasks;
+//     void PushItem(Thread&, const Item&), puts shared tasks on the stack;
+//     void DoTasks(Thread&, Pool&), does a packet of the tasks;
+//     bool HasNewTasks(const Pool&) and bool TakeNewTasks(Thread&, Pool&), tasks of other
+//     sources, e.g. submitted queries. They are taken before stealing.
+template <typename Policy>
+class Scheduler
+{
+public:
+    using Item = typename Policy::Item;
+    using Thread = typename Policy::Thread;
+    using Pool = typename Policy::Pool;
+
+private:
+    // Current time for spans, 0 if profiling is off.
+    static double GetSpanStart(const Pool& pool)
+    {
+        return pool.Profile ? GetProfileTime(pool.StartTime) : 0;
+    }
+
+    static void AddSpan(Thread& thread, const Pool& pool, SpanKind kind, double start)
+    {
+        if (!pool.Profile)
+            return;
+
+        double stop = GetProfileTime(pool.StartTime);
+        thread.Profile.Spans.push_back({kind, start, stop});
+
+        switch (kind)
+        {
+            case SpanKind::Work:
+                thread.Profile.WorkTime += stop - start;
+                break;
+            case SpanKind::Steal:
+                thread.Profile.StealTime += stop - start;
+                break;
+            case SpanKind::Park:
+                thread.Profile.ParkTime += stop - start;
+                break;
+        }
+    }
+
+    // Samples the queue depths once per ProfileSampleInterval at most.
+    static void SampleDepth(Thread& thread, const Pool& pool)
+    {
+        double time = GetProfileTime(pool.StartTime);
+        std::vector<DepthSample>& depth = thread.Profile.Depth;
+        if (!depth.empty() && time - depth.back().Time < ProfileSampleInterval)
+            return;
+
+        depth.push_back({time, static_cast<uint32_t>(Policy::GetTasksCount(thread)),
+                         static_cast<uint32_t>(thread.SharedTasks->Size()), thread.Profile.TasksDone});
+    }
+
+    // Moves the oldest private tasks, up to a half of them, to the shared deque
+    // if thieves have emptied it.
+    static void ShareTasks(Thread& thread, Pool& pool)
+    {
+        if (thread.SharedTasks->Size() != 0)
+            return;
+
+        size_t total = Policy::GetTasksCount(thread);
+        size_t shared = 0;
+        Item item = {};
+        for (size_t st = 0; st < pool.ThreadsNumber && 2 * shared < total && Policy::TakeOldest(thread, item); st++)
+        {
+            shared += Policy::GetTasksCount(item);
+            thread.SharedTasks->Push(item);
+        }
+
+        thread.Profile.TasksShared += shared;
+
+        if (shared > 0)
+            WakeParkedThreads(pool);
+    }
+
+    // Sleeps until tasks are shared or given or the work is over.
+    static void Park(Thread& thread, Pool& pool)
+    {
+        double start = GetSpanStart(pool);
+        thread.Profile.Parks++;
+
+        // The signal is read before the checks, so a change made after them wakes the thread at once.
+        uint32_t signal = pool.WorkSignal.load();
+        pool.ParkedThreads.fetch_add(1);
+
+        if (pool.ActiveThreads.load() != 0 && !HasSharedTasks(pool) && !Policy::HasNewTasks(pool))
+            pool.WorkSignal.wait(signal);
+
+        pool.ParkedThreads.fetch_sub(1);
+
+        AddSpan(thread, pool, SpanKind::Park, start);
+    }
+
+    // Takes back an item from the own shared deque.
+    static bool TakeSharedTask(Thread& thread)
+    {
+        Item item = {};
+        if (!thread.SharedTasks->Pop(item))
+            return false;
+
+        thread.Profile.TasksTakenBack += Policy::GetTasksCount(item);
+        Policy::PushItem(thread, item);
+        return true;
+    }
+
+    static uint64_t NextRandom(Thread& thread)
+    {
+        uint64_t x = thread.RandomState;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        thread.RandomState = x;
+        return x;
+    }
+
+    // Takes new tasks or steals the oldest shared item of a random victim, parks after
+    // StealSpinRounds failed rounds. A round tries the neighbours first, their items are in
+    // the memory of the same package. Returns false if all threads are idle, i.e. all tasks are done.
+    static bool StealTasks(Thread& thread, Pool& pool)
+    {
+        double start = GetSpanStart(pool);
+        for (size_t round = 1; ; round++)
+        {
+            if (pool.ActiveThreads.load() == 0)
+            {
+                AddSpan(thread, pool, SpanKind::Steal, start);
+                return false;
+            }
+
+            // Become active before taking tasks, so the work is never unaccounted.
+            if (Policy::HasNewTasks(pool))
+            {
+                pool.ActiveThreads.fetch_add(1);
+                if (Policy::TakeNewTasks(thread, pool))
+                {
+                    AddSpan(thread, pool, SpanKind::Steal, start);
+                    return true;
+                }
+                LeaveActiveThreads(pool);
+            }
+
+            size_t neighbours = thread.Neighbours.size();
+            for (size_t attempt = 0; attempt < neighbours + pool.DequesCount; attempt++)
+            {
+                size_t victim = attempt < neighbours ? thread.Neighbours[NextRandom(thread) % neighbours]
+                                                     : NextRandom(thread) % pool.DequesCount;
+                if (victim == thread.ProcNumber || pool.SharedTasks[victim].Size() == 0)
+                    continue;
+
+                pool.ActiveThreads.fetch_add(1);
+
+                thread.Profile.StealAttempts++;
+
+                Item item = {};
+                if (pool.SharedTasks[victim].Steal(item))
+                {
+                    thread.Profile.TasksStolen += Policy::GetTasksCount(item);
+                    Policy::PushItem(thread, item);
+
+                    if (DEBUG)
+                        std::cout << "THREAD[" << thread.ProcNumber << "] stole tasks of THREAD[" << victim << "]." << std::endl;
+
+                    AddSpan(thread, pool, SpanKind::Steal, start);
+                    return true;
+                }
+
+                thread.Profile.FailedSteals++;
+                LeaveActiveThreads(pool);
+            }
+
+            if (round % StealSpinRounds == 0)
+                Park(thread, pool);
+            else
+                sched_yield();
+        }
+    }
+
+public:
+    // Runs the thread until all tasks are done. Every thread starts active, e.g. with its share
+    // of the start tasks.
+    static void Run(Thread& thread, Pool& pool)
+    {
+        do
+        {
+            double start = GetSpanStart(pool);
+            while (Policy::GetTasksCount(thread) > 0 || TakeSharedTask(thread))
+            {
+                Policy::DoTasks(thread, pool);
+
+                size_t tasksCount = Policy::GetTasksCount(thread);
+                if (thread.Profile.MaxTasksCount < tasksCount)
+                    thread.Profile.MaxTasksCount = tasksCount;
+
+                ShareTasks(thread, pool);
+
+                if (pool.Profile)
+                    SampleDepth(thread, pool);
+
+                if (DEBUG)
+                    std::cout << "THREAD[" << thread.ProcNumber << "] done " << thread.Profile.TasksDone << " tasks." << std::endl;
+            }
+            AddSpan(thread, pool, SpanKind::Work, start);
+
+            LeaveActiveThreads(pool);
+
+            if (DEBUG)
+                std::cout << "THREAD[" << thread.ProcNumber << "] is stealing..." << std::endl;
+        }
+        while (StealTasks(thread, pool));
+    }
+};
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "taskstack.h"
+
+static double Lock(sem_t* access)
+{
+    auto start = std::chrono::steady_clock::now();
+    sem_wait(access);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+TaskArena::TaskArena()
+{
+    sem_init(&Access, 0, 1);
+}
+
+TaskArena::~TaskArena()
+{
+    sem_destroy(&Access);
+}
+
+double TaskArena::Allocate(std::vector<TaskChunk*>& chunks)
+{
+    double waitTime = Lock(&Access);
+
+    if (Free.size() < TaskSlabChunks)
+    {
+        // Pages are touched by the thread that fills the chunks.
+        TaskChunk* slab = new TaskChunk[TaskSlabChunks];
+        Slabs.emplace_back(slab);
+        for (size_t st = 0; st < TaskSlabChunks; st++)
+            Free.push_back(slab + st);
+    }
+
+    chunks.insert(chunks.end(), Free.end() - TaskSlabChunks, Free.end());
+    Free.resize(Free.size() - TaskSlabChunks);
+
+    sem_post(&Access);
+    return waitTime;
+}
+
+double TaskArena::Release(TaskChunk* const* chunks, size_t count)
+{
+    double waitTime = Lock(&Access);
+    Free.insert(Free.end(), chunks, chunks + count);
+    sem_post(&Access);
+    return waitTime;
+}
+
+TaskStack::TaskStack() :
+    Arena(nullptr),
+    Top(nullptr),
+    TasksCount(0),
+    LockWaitTime(0)
+{
+}
+
+TaskStack::TaskStack(TaskArena& arena) :
+    Arena(&arena),
+    Top(nullptr),
+    TasksCount(0),
+    LockWaitTime(0)
+{
+}
+
+TaskStack::~TaskStack()
+{
+    if (!Arena)
+        return;
+
+    Arena->Release(Chunks.data(), Chunks.size());
+    Arena->Release(Spare.data(), Spare.size());
+}
+
+TaskStack::TaskStack(TaskStack&& stack) :
+    Arena(stack.Arena),
+    Chunks(std::move(stack.Chunks)),
+    Top(stack.Top),
+    Spare(std::move(stack.Spare)),
+    TasksCount(stack.TasksCount),
+    LockWaitTime(stack.LockWaitTime)
+{
+    stack.Chunks.clear();
+    stack.Top = nullptr;
+    stack.Spare.clear();
+    stack.TasksCount = 0;
+}
+
+TaskStack& TaskStack::operator = (TaskStack&& stack)
+{
+    if (this == &stack)
+        return *this;
+
+    if (Arena)
+    {
+        Arena->Release(Chunks.data(), Chunks.size());
+        Arena->Release(Spare.data(), Spare.size());
+    }
+
+    Arena = stack.Arena;
+    Chunks = std::move(stack.Chunks);
+    Top = stack.Top;
+    Spare = std::move(stack.Spare);
+    TasksCount = stack.TasksCount;
+    LockWaitTime = stack.LockWaitTime;
+
+    stack.Chunks.clear();
+    stack.Top = nullptr;
+    stack.Spare.clear();
+    stack.TasksCount = 0;
+    return *this;
+}
+
+TaskChunk* TaskStack::NewChunk()
+{
+    if (Spare.empty())
+        LockWaitTime += Arena->Allocate(Spare);
+
+    TaskChunk* chunk = Spare.back();
+    Spare.pop_back();
+
+    chunk->Halves = 0;
+    chunk->Count = 0;
+    return chunk;
+}
+
+void TaskStack::ResetTop()
+{
+    Top = Chunks.empty() ? nullptr : Chunks.back();
+}
+
+void TaskStack::Grow()
+{
+    Chunks.push_back(NewChunk());
+    ResetTop();
+}
+
+void TaskStack::Shrink()
+{
+    Spare.push_back(Top);
+    Chunks.pop_back();
+    ResetTop();
+
+    if (Spare.size() > SpareChunks)
+    {
+        LockWaitTime += Arena->Release(Spare.data() + TaskSlabChunks, Spare.size() - TaskSlabChunks);
+        Spare.resize(TaskSlabChunks);
+    }
+}
+
+TaskChunk* TaskStack::TakeOldest()
+{
+    if (TasksCount < 2)
+        return nullptr;
+
+    if (Top->Count == 0)
+        Shrink();
+
+    if (Chunks.size() > 1)
+        return TakeBottom();
+
+    TaskChunk& chunk = *Chunks.front();
+    TaskChunk* oldest = NewChunk();
+
+    if (chunk.Count == 1)
+    {
+        // Both halves of one node, the left one is older.
+        TaskNode& node = chunk.Nodes[0];
+        oldest->Nodes[0] = node;
+        oldest->Halves = 1;
+        oldest->Count = 1;
+
+        node = {{node.x[1], node.x[2], node.x[2]}, {node.f[1], node.f[2], node.f[2]}, {node.Slots[1], 0}};
+        chunk.Halves = 1;
+        TasksCount--;
+        return oldest;
+    }
+
+    size_t count = chunk.Count / 2;
+    memcpy(oldest->Nodes, chunk.Nodes, count * sizeof(TaskNode));
+    oldest->Halves = chunk.Halves & ((1ull << count) - 1);
+    oldest->Count = count;
+
+    memmove(chunk.Nodes, chunk.Nodes + count, (chunk.Count - count) * sizeof(TaskNode));
+    chunk.Halves >>= count;
+    chunk.Count -= count;
+
+    TasksCount -= GetTasksCount(*oldest);
+    return oldest;
+}
+
+TaskChunk* TaskStack::TakeBottom()
+{
+    if (TasksCount == 0)
+        return nullptr;
+
+    if (Top->Count == 0)
+        Shrink();
+
+    TaskChunk* chunk = Chunks.front();
+    Chunks.erase(Chunks.begin());
+    ResetTop();
+    TasksCount -= GetTasksCount(*chunk);
+    return chunk;
+}
+
+void TaskStack::PushChunk(TaskChunk* chunk)
+{
+    // A partial top chunk stays below, only the top one is filled.
+    if (Top && Top->Count == 0)
+        Shrink();
+
+    Chunks.push_back(chunk);
+    ResetTop();
+    TasksCount += GetTasksCount(*chunk);
+}
+
+void TaskStack::MoveTo(TaskArena& arena)
+{
+    assert(Arena);
+    if (Arena == &arena)
+        return;
+
+    std::vector<TaskChunk*> chunks = std::move(Chunks);
+    Chunks.clear();
+
+    LockWaitTime += Arena->Release(Spare.data(), Spare.size());
+    Spare.clear();
+
+    TaskArena* oldArena = Arena;
+    Arena = &arena;
+    for (TaskChunk* chunk : chunks)
+    {
+        TaskChunk* copy = NewChunk();
+        memcpy(copy->Nodes, chunk->Nodes, chunk->Count * sizeof(TaskNode));
+        copy->Halves = chunk->Halves;
+        copy->Count = chunk->Count;
+        Chunks.push_back(copy);
+    }
+    ResetTop();
+
+    LockWaitTime += oldArena->Release(chunks.data(), chunks.size());
+}
\ No newline at end of file
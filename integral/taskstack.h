@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <semaphore.h>
+
+struct Task
+{
+    double x1;
+    double x2;
+    // Cached samples, reused by the halves.
+    double f1;
+    double f2;
+    // Trapezoid and Gauss-Kronrod tasks keep the integral over [x1, x2]. Simpson ones keep
+    // the sample at the midpoint and get the integral from the samples, so a task is 40 bytes.
+    union
+    {
+        double Int;
+        double fm;
+    };
+};
+
+// Nodes of a chunk, a bit of TaskChunk::Halves per node.
+const size_t TaskChunkNodes = 64;
+
+// Chunks allocated by the arena at once.
+const size_t TaskSlabChunks = 16;
+
+// Free chunks a stack keeps, the rest go back to the arena.
+const size_t SpareChunks = 2 * TaskSlabChunks;
+
+// Halves of a split share the split point and its sample, so they are kept as one node
+// relative to the parent: a cache line for two tasks instead of 80 bytes.
+// Halves are [x[0], x[1]] and [x[1], x[2]], a single task is a node without its right half.
+struct TaskNode
+{
+    double x[3];
+    double f[3];
+    // Int or fm of the halves.
+    double Slots[2];
+};
+
+struct alignas(64) TaskChunk
+{
+    TaskNode Nodes[TaskChunkNodes];
+    // Bit i is set if node i has no right half.
+    uint64_t Halves;
+    size_t Count;
+};
+
+// Tasks of the chunk.
+inline size_t GetTasksCount(const TaskChunk& chunk)
+{
+    return 2 * chunk.Count - __builtin_popcountll(chunk.Halves);
+}
+
+// Chunks of all stacks. They are allocated by slabs and live until the arena is destroyed,
+// stacks keep freed chunks for reuse, so the lock is taken only when a stack grows.
+class TaskArena
+{
+private:
+    sem_t Access;
+    std::vector<std::unique_ptr<TaskChunk[]>> Slabs;
+    std::vector<TaskChunk*> Free;
+
+public:
+    TaskArena();
+    ~TaskArena();
+
+    TaskArena(const TaskArena&) = delete;
+    TaskArena& operator = (const TaskArena&) = delete;
+
+    // Adds TaskSlabChunks chunks to chunks. Both return the wait for the lock, ms.
+    double Allocate(std::vector<TaskChunk*>& chunks);
+    double Release(TaskChunk* const* chunks, size_t count);
+};
+
+// LIFO stack of tasks in chunks. Whole chunks are handed over to other stacks by pointer,
+// e.g. through the shared deques, the oldest tasks are in the bottom chunk.
+class TaskStack
+{
+private:
+    TaskArena* Arena;
+    // Bottom first. Only the top chunk is filled and may be empty, the ones below may be partial.
+    std::vector<TaskChunk*> Chunks;
+    // Chunks.back() or nullptr.
+    TaskChunk* Top;
+    std::vector<TaskChunk*> Spare;
+    size_t TasksCount;
+    // Waits for the lock of the arena, ms.
+    double LockWaitTime;
+
+    TaskChunk* NewChunk();
+    // Pushes a new top chunk.
+    void Grow();
+    // Frees the empty top chunk.
+    void Shrink();
+    void ResetTop();
+
+    TaskNode& PushNode(bool half)
+    {
+        if (!Top || Top->Count == TaskChunkNodes)
+            Grow();
+
+        if (half)
+            Top->Halves |= 1ull << Top->Count;
+
+        TasksCount += half ? 1 : 2;
+        return Top->Nodes[Top->Count++];
+    }
+
+public:
+    TaskStack();
+    explicit TaskStack(TaskArena& arena);
+    ~TaskStack();
+
+    TaskStack(TaskStack&& stack);
+    TaskStack& operator = (TaskStack&& stack);
+
+    size_t Size() const
+    {
+        return TasksCount;
+    }
+
+    double GetLockWaitTime() const
+    {
+        return LockWaitTime;
+    }
+
+    void Push(const Task& task)
+    {
+        TaskNode& node = PushNode(true);
+        node = {{task.x1, task.x2, task.x2}, {task.f1, task.f2, task.f2}, {task.Int, 0}};
+    }
+
+    // Halves of a split, t2 is on the top.
+    void Push(const Task& t1, const Task& t2)
+    {
+        assert(t1.x2 == t2.x1 && t1.f2 == t2.f1);
+
+        TaskNode& node = PushNode(false);
+        node = {{t1.x1, t1.x2, t2.x2}, {t1.f1, t1.f2, t2.f2}, {t1.Int, t2.Int}};
+    }
+
+    // Pops min(count, Size()) tasks, tasks[0] is the deepest one. Returns the number of tasks.
+    size_t Pop(Task* tasks, size_t count)
+    {
+        count = count < TasksCount ? count : TasksCount;
+        TasksCount -= count;
+
+        size_t st = count;
+        while (st > 0)
+        {
+            // State of the top chunk is kept in registers.
+            TaskChunk* chunk = Top;
+            uint64_t halves = chunk->Halves;
+            size_t nodes = chunk->Count;
+
+            while (st > 0 && nodes > 0)
+            {
+                const TaskNode& node = chunk->Nodes[nodes - 1];
+                size_t left = (halves >> (nodes - 1)) & 1;
+
+                // Usually whole nodes are popped.
+                if (!left && st >= 2)
+                {
+                    tasks[st - 1] = {node.x[1], node.x[2], node.f[1], node.f[2], {node.Slots[1]}};
+                    tasks[st - 2] = {node.x[0], node.x[1], node.f[0], node.f[1], {node.Slots[0]}};
+                    st -= 2;
+                    nodes--;
+                    continue;
+                }
+
+                // The right half if it is there, then the left one, without branches.
+                size_t half = 1 - left;
+
+                st--;
+                tasks[st] = {node.x[half], node.x[half + 1], node.f[half], node.f[half + 1], {node.Slots[half]}};
+                halves ^= 1ull << (nodes - 1);
+                nodes -= left;
+            }
+
+            chunk->Halves = halves;
+            chunk->Count = nodes;
+
+            // An empty top chunk is kept for the next pushes, stacks often shrink and grow
+            // across a chunk boundary.
+            if (nodes == 0 && st > 0)
+                Shrink();
+        }
+
+        return count;
+    }
+
+    // Removes the oldest tasks: the bottom chunk, or the older half of the only chunk.
+    // Returns nullptr if the stack has less than 2 tasks.
+    TaskChunk* TakeOldest();
+
+    // Removes the bottom chunk, nullptr if the stack is empty.
+    TaskChunk* TakeBottom();
+
+    // Puts a chunk of another stack on the top.
+    void PushChunk(TaskChunk* chunk);
+
+    // Copies the tasks to chunks of the arena, e.g. of the NUMA node of the calling thread,
+    // which touches their pages first. The old chunks go back to the old arena.
+    void MoveTo(TaskArena& arena);
+};
+
+inline void PushSplit(TaskStack& tasks, const Task& t1, const Task& t2)
+{
+    tasks.Push(t1, t2);
+}
\ No newline at end of file
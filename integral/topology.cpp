@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <pthread.h>
+#include <sched.h>
+
+#include "topology.h"
+
+static bool ReadNumber(const std::string& fileName, int& value)
+{
+    std::ifstream file(fileName);
+    return static_cast<bool>(file >> value);
+}
+
+// Parses cpu lists like 0-3,8,10-11.
+static std::vector<int> ParseCpuList(const std::string& list)
+{
+    std::vector<int> cpus;
+    size_t position = 0;
+    while (position < list.size())
+    {
+        size_t end = list.find(',', position);
+        if (end == std::string::npos)
+            end = list.size();
+
+        std::string range = list.substr(position, end - position);
+        size_t dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+
+        position = end + 1;
+    }
+    return cpus;
+}
+
+bool Topology::Load()
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        std::cout << "Can not get the CPUs of the process: " << strerror(errno) << "." << std::endl;
+        return false;
+    }
+
+    Cpus.clear();
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (!CPU_ISSET(cpu, &allowed))
+            continue;
+
+        std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        CpuPlace place = {cpu, 0, cpu, 0};
+        if (!ReadNumber(path + "physical_package_id", place.Package) || !ReadNumber(path + "core_id", place.Core))
+        {
+            place.Package = 0;
+            place.Core = cpu;
+        }
+        Cpus.push_back(place);
+    }
+
+    NodesCount = 1;
+    for (int node = 0; ; node++)
+    {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!(file >> list))
+            break;
+
+        for (int cpu : ParseCpuList(list))
+        {
+            for (CpuPlace& place : Cpus)
+            {
+                if (place.Cpu == cpu)
+                {
+                    place.Node = node;
+                    NodesCount = std::max(NodesCount, static_cast<size_t>(node) + 1);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+std::vector<CpuPlace> Topology::Place(PinPolicy policy, size_t threadsCount) const
+{
+    // Hyperthread of a CPU in its core and rank of the core in its package.
+    struct Key
+    {
+        CpuPlace Place;
+        size_t Sibling;
+        size_t CoreRank;
+    };
+
+    std::vector<Key> keys;
+    for (const CpuPlace& place : Cpus)
+    {
+        Key key = {place, 0, 0};
+        std::vector<int> cores;
+        for (const CpuPlace& other : Cpus)
+        {
+            if (other.Package != place.Package)
+                continue;
+
+            if (other.Core == place.Core && other.Cpu < place.Cpu)
+                key.Sibling++;
+            if (other.Core < place.Core && std::find(cores.begin(), cores.end(), other.Core) == cores.end())
+                cores.push_back(other.Core);
+        }
+        key.CoreRank = cores.size();
+        keys.push_back(key);
+    }
+
+    auto order = [policy](const Key& a, const Key& b)
+    {
+        switch (policy)
+        {
+            case PinPolicy::None:
+            case PinPolicy::Compact:
+                return std::tie(a.Place.Package, a.CoreRank, a.Sibling) < std::tie(b.Place.Package, b.CoreRank, b.Sibling);
+            case PinPolicy::Scatter:
+                return std::tie(a.Sibling, a.CoreRank, a.Place.Package) < std::tie(b.Sibling, b.CoreRank, b.Place.Package);
+            case PinPolicy::Physical:
+                return std::tie(a.Sibling, a.Place.Package, a.CoreRank) < std::tie(b.Sibling, b.Place.Package, b.CoreRank);
+        }
+        return false;
+    };
+    std::stable_sort(keys.begin(), keys.end(), order);
+
+    std::vector<CpuPlace> places;
+    for (size_t st = 0; st < threadsCount && !keys.empty(); st++)
+        places.push_back(keys[st % keys.size()].Place);
+    return places;
+}
+
+bool ParsePinPolicy(const char* name, PinPolicy& policy)
+{
+    for (PinPolicy known : {PinPolicy::None, PinPolicy::Compact, PinPolicy::Scatter, PinPolicy::Physical})
+    {
+        if (strcmp(name, GetPinPolicyName(known)) == 0)
+        {
+            policy = known;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* GetPinPolicyName(PinPolicy policy)
+{
+    switch (policy)
+    {
+        case PinPolicy::None:
+            return "none";
+        case PinPolicy::Compact:
+            return "compact";
+        case PinPolicy::Scatter:
+            return "scatter";
+        case PinPolicy::Physical:
+            return "physical";
+    }
+    return "";
+}
+
+bool PinThread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (error != 0)
+    {
+        std::cout << "Can not pin the thread to CPU " << cpu << ": " << strerror(error) << "." << std::endl;
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Placement of the worker threads on the CPUs.
+enum class PinPolicy
+{
+    // Threads are left to the OS scheduler.
+    None,
+    // Neighbour threads share cores and packages: hyperthreads of a core, then cores of a package.
+    Compact,
+    // Neighbour threads go to different packages, then to different cores of a package.
+    Scatter,
+    // A thread per physical core, hyperthreads are used only if there are more threads than cores.
+    Physical
+};
+
+struct CpuPlace
+{
+    int Cpu;
+    // Socket.
+    int Package;
+    int Core;
+    // NUMA node.
+    int Node;
+};
+
+// CPUs the process may run on, read from /sys/devices/system/cpu and /sys/devices/system/node.
+// Missing files are taken as a core per CPU, one package and one node, e.g. in containers.
+class Topology
+{
+private:
+    std::vector<CpuPlace> Cpus;
+    size_t NodesCount;
+
+public:
+    // Prints the problem and returns false on errors.
+    bool Load();
+
+    size_t GetCpusCount() const
+    {
+        return Cpus.size();
+    }
+
+    size_t GetNodesCount() const
+    {
+        return NodesCount;
+    }
+
+    // CPUs of threadsCount threads. Threads wrap around the CPUs if there are more of them.
+    std::vector<CpuPlace> Place(PinPolicy policy, size_t threadsCount) const;
+};
+
+// none, compact, scatter or physical. Returns false on other names.
+bool ParsePinPolicy(const char* name, PinPolicy& policy);
+
+const char* GetPinPolicyName(PinPolicy policy);
+
+// Binds the calling thread to the CPU. Prints the problem and returns false on errors.
+bool PinThread(int cpu);
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+// Branchless sin that GCC vectorizes inside loops (4 lanes with -mavx2, 8 with -mavx512f).
+// Cody-Waite reduction by pi/2 split into 33 bit parts, n * part is exact for n < 2^20,
+// then the fdlibm minimax polynomials of sin and cos on [-pi/4, pi/4].
+// Absolute error is about 1 ulp of the result for |x| < SinReductionLimit.
+namespace VecSin
+{
+    // Adding and subtracting 1.5 * 2^52 rounds to the nearest integer.
+    const double RoundMagic = 6755399441055744.0;
+
+    const double InvPio2 = 6.36619772367581382433e-01;
+    const double Pio2_1  = 1.57079632673412561417e+00;
+    const double Pio2_2  = 6.07710050630396597660e-11;
+    const double Pio2_2t = 2.02226624879595063154e-21;
+
+    const double S1 = -1.66666666666666324348e-01;
+    const double S2 =  8.33333333332248946124e-03;
+    const double S3 = -1.98412698298579493134e-04;
+    const double S4 =  2.75573137070700676789e-06;
+    const double S5 = -2.50507602534068634195e-08;
+    const double S6 =  1.58969099521155010221e-10;
+
+    const double C1 =  4.16666666666666019037e-02;
+    const double C2 = -1.38888888888741095749e-03;
+    const double C3 =  2.48015872894767294178e-05;
+    const double C4 = -2.75573143513906633035e-07;
+    const double C5 =  2.08757232129817482790e-09;
+    const double C6 = -1.13596475577881948265e-11;
+}
+
+const double SinReductionLimit = 1048576.0 * VecSin::Pio2_1;
+
+// sin(x + shift pi/2), shift is 0 or 1.
+inline double SinShifted(double x, double shift)
+{
+    using namespace VecSin;
+
+    // x = n pi/2 + r, |r| <= pi/4.
+    double n = (x * InvPio2 + RoundMagic) - RoundMagic;
+    double r = (x - n * Pio2_1) - n * Pio2_2 - n * Pio2_2t;
+    n += shift;
+    // floor(n / 4), the fraction of n / 4 - 0.375 is never 0.5.
+    double n4 = ((n * 0.25 - 0.375) + RoundMagic) - RoundMagic;
+    double quadrant = n - 4 * n4;
+
+    double z = r * r;
+    double s = r + r * z * (S1 + z * (S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)))));
+
+    double hz = 0.5 * z;
+    double w  = 1 - hz;
+    double c  = w + (((1 - w) - hz) + z * z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6))))));
+
+    bool odd = (quadrant == 1) | (quadrant == 3);
+    double value = odd ? c : s;
+    double sign = quadrant >= 2 ? -1.0 : 1.0;
+    return sign * value;
+}
+
+inline double Sin(double x)
+{
+    return SinShifted(x, 0);
+}
+
+inline double Cos(double x)
+{
+    return SinShifted(x, 1);
+}
+
+// y[i] = sin(x[i]). Arguments out of the reduction range are recomputed with std::sin.
+inline void SinBatch(const double* __restrict__ x, double* __restrict__ y, size_t count)
+{
+    for (size_t st = 0; st < count; st++)
+        y[st] = Sin(x[st]);
+
+    for (size_t st = 0; st < count; st++)
+    {
+        if (std::abs(x[st]) >= SinReductionLimit)
+            y[st] = std::sin(x[st]);
+    }
+}
+
+// y[i] = cos(x[i]), see SinBatch().
+inline void CosBatch(const double* __restrict__ x, double* __restrict__ y, size_t count)
+{
+    for (size_t st = 0; st < count; st++)
+        y[st] = Cos(x[st]);
+
+    for (size_t st = 0; st < count; st++)
+    {
+        if (std::abs(x[st]) >= SinReductionLimit)
+            y[st] = std::cos(x[st]);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Alignment of the arrays streamed by the SIMD kernels (one cache line, one AVX-512 register).
+const size_t SimdAlignment = 64;
+
+// Array of doubles laid out as a mesh layer:
+//   [-GhostCells, -1]   start boundary (ghost) cells,
+//   [0, Size - 1]       inner cells, first one starts on SimdAlignment boundary,
+//   [Size, Size + GhostCells - 1] stop boundary (ghost) cells.
+class AlignedLayer
+{
+private:
+    static const size_t AlignedDoubles = SimdAlignment / sizeof(double);
+
+    size_t Offset;
+    double* Storage;
+
+public:
+    const size_t Size;
+    const size_t GhostCells;
+
+    AlignedLayer(size_t size, size_t ghostCells = 1) :
+        Offset((ghostCells + AlignedDoubles - 1) / AlignedDoubles * AlignedDoubles),
+        Storage(nullptr),
+        Size(size),
+        GhostCells(ghostCells)
+    {
+        size_t bytes = (Offset + Size + GhostCells) * sizeof(double);
+        bytes = (bytes + SimdAlignment - 1) / SimdAlignment * SimdAlignment;
+
+        Storage = static_cast<double*>(std::aligned_alloc(SimdAlignment, bytes));
+        if (!Storage)
+            throw std::bad_alloc();
+
+        for (size_t st = 0; st < bytes / sizeof(double); st++)
+            Storage[st] = 0;
+    }
+
+    AlignedLayer(const AlignedLayer&) = delete;
+    AlignedLayer& operator = (const AlignedLayer&) = delete;
+
+    ~AlignedLayer()
+    {
+        std::free(Storage);
+    }
+
+    double* Inner()
+    {
+        return Storage + Offset;
+    }
+
+    const double* Inner() const
+    {
+        return Storage + Offset;
+    }
+};
\ No newline at end of file
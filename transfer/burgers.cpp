@@ -0,0 +1,199 @@
+#include <cmath>
+
+#include "constant.h"
+#include "functions.h"
+#include "burgers.h"
+
+static inline double Min(double left, double right)
+{
+    return left < right ? left : right;
+}
+
+static inline double Max(double left, double right)
+{
+    return left > right ? left : right;
+}
+
+// Branchless limiters: the sign factor is 1 or -1 for slopes of the same sign and 0 otherwise,
+// so the compiler turns them into min/max/and instructions and vectorizes the slope loop.
+struct MinmodLimiter
+{
+    static inline double Apply(double left, double right)
+    {
+        double sign = std::copysign(0.5, left) + std::copysign(0.5, right);
+        return sign * Min(std::fabs(left), std::fabs(right));
+    }
+};
+
+struct SuperbeeLimiter
+{
+    static inline double Apply(double left, double right)
+    {
+        double sign = std::copysign(0.5, left) + std::copysign(0.5, right);
+        double absLeft  = std::fabs(left);
+        double absRight = std::fabs(right);
+        return sign * Max(Min(2 * absLeft, absRight), Min(absLeft, 2 * absRight));
+    }
+};
+
+static inline double Flux(double u)
+{
+    return u * u / 2;
+}
+
+template <typename LimiterType>
+static void ComputeSlopes(const double* __restrict__ u, double* __restrict__ slope, size_t count)
+{
+    // slope[m] is the slope of cell m - 1, m = [0, count + 1].
+    const double* u_mm1 = u - 2;
+    const double* u_m   = u - 1;
+    const double* u_mp1 = u;
+    for (size_t m = 0; m < count + 2; m++)
+        slope[m] = LimiterType::Apply(u_m[m] - u_mm1[m], u_mp1[m] - u_m[m]);
+}
+
+static void ComputeFluxes(const double* __restrict__ u, const double* __restrict__ slope,
+                          double* __restrict__ flux, double dtOverH, size_t count)
+{
+    // flux[m] is the flux through the face between cells m - 1 and m, m = [0, count].
+    const double* u_l = u - 1;
+    for (size_t m = 0; m < count + 1; m++)
+    {
+        // Hancock predictor: half time step evolution of the reconstructed face values.
+        double sl = slope[m];
+        double sr = slope[m + 1];
+
+        double lm = u_l[m] - sl / 2;
+        double lp = u_l[m] + sl / 2;
+        double left = lp + dtOverH / 2 * (Flux(lm) - Flux(lp));
+
+        double rm = u[m] - sr / 2;
+        double rp = u[m] + sr / 2;
+        double right = rm + dtOverH / 2 * (Flux(rm) - Flux(rp));
+
+        // Exact Riemann solver for the convex flux u^2/2: max(f(max(left, 0)), f(min(right, 0))).
+        // (x + |x|)/2 and (x - |x|)/2 are exact and keep the loop free of branches.
+        double leftPos  = (left  + std::fabs(left))  / 2;
+        double rightNeg = (right - std::fabs(right)) / 2;
+        flux[m] = Max(Flux(leftPos), Flux(rightNeg));
+    }
+}
+
+void ComputeCellsBurgersTvd(const double* u_k, double* u_k1, double* slope, double* flux,
+                            double dtOverH, ::Limiter limiter, size_t count)
+{
+    switch (limiter)
+    {
+        case Limiter::Minmod:
+            ComputeSlopes<MinmodLimiter>(u_k, slope, count);
+            break;
+
+        case Limiter::Superbee:
+            ComputeSlopes<SuperbeeLimiter>(u_k, slope, count);
+            break;
+    }
+
+    ComputeFluxes(u_k, slope, flux, dtOverH, count);
+
+    for (size_t m = 0; m < count; m++)
+        u_k1[m] = u_k[m] - dtOverH * (flux[m + 1] - flux[m]);
+}
+
+double ComputeBurgersMaxSpeed(const double* u, size_t count)
+{
+    // Independent lanes, so the reduction is vectorized without reassociation flags.
+    const size_t Lanes = SimdAlignment / sizeof(double);
+    double speeds[Lanes] = {};
+
+    size_t m = 0;
+    for (; m + Lanes <= count; m += Lanes)
+        for (size_t lane = 0; lane < Lanes; lane++)
+            speeds[lane] = Max(speeds[lane], std::fabs(u[m + lane]));
+
+    double speed = 0;
+    for (; m < count; m++)
+        speed = Max(speed, std::fabs(u[m]));
+    for (size_t lane = 0; lane < Lanes; lane++)
+        speed = Max(speed, speeds[lane]);
+    return speed;
+}
+
+BurgersDomain::BurgersDomain(const size_t meshSize, const double x1, ::Limiter limiter) :
+    xLeft(x1),
+    Mesh(meshSize, xLeft, h, BurgersGhostCells),
+    Limiter(limiter),
+    Slope(meshSize + 2),
+    Flux(meshSize + 1)
+{
+    SetSpatialBoundary();
+}
+
+void BurgersDomain::SetSpatialBoundary()
+{
+    double* u = Mesh.GetLayer(Time::Prev) - BurgersGhostCells;
+    const double* x = Mesh.GetX() - BurgersGhostCells;
+    for (size_t st = 0; st < Mesh.MeshSize + 2 * BurgersGhostCells; st++)
+        u[st] = ComputeSpatialBoundary(x[st]);
+}
+
+double BurgersDomain::GetMaxSpeed() const
+{
+    return ComputeBurgersMaxSpeed(Mesh.GetLayer(Time::Prev), Mesh.MeshSize);
+}
+
+void BurgersDomain::ComputeCells(double dt)
+{
+    ComputeCellsBurgersTvd(Mesh.GetLayer(Time::Prev), Mesh.GetLayer(Time::Curr),
+                           Slope.Inner(), Flux.Inner(), dt / h, Limiter, Mesh.MeshSize);
+}
+
+void BurgersDomain::SetTimeBoundary(double t)
+{
+    double value = ComputeTimeBoundary(t);
+    double* boundary = GetStartBoundary();
+    for (size_t st = 0; st < BurgersGhostCells; st++)
+        boundary[st] = value;
+}
+
+void BurgersDomain::ApproximateTimeBoundary()
+{
+    double value = Mesh.GetValue(Mesh.MeshSize - 1, Time::Curr);
+    double* boundary = GetStopBoundary();
+    for (size_t st = 0; st < BurgersGhostCells; st++)
+        boundary[st] = value;
+}
+
+const double* BurgersDomain::GetStartInnerCells() const
+{
+    return Mesh.GetLayer(Time::Curr);
+}
+
+const double* BurgersDomain::GetStopInnerCells() const
+{
+    return Mesh.GetLayer(Time::Curr) + Mesh.MeshSize - BurgersGhostCells;
+}
+
+double* BurgersDomain::GetStartBoundary()
+{
+    return Mesh.GetLayer(Time::Curr) - BurgersGhostCells;
+}
+
+double* BurgersDomain::GetStopBoundary()
+{
+    return Mesh.GetLayer(Time::Curr) + Mesh.MeshSize;
+}
+
+void BurgersDomain::NextTimeStep()
+{
+    Mesh.NextTimeStep();
+}
+
+const ::Mesh& BurgersDomain::GetMesh() const
+{
+    return Mesh;
+}
+
+std::stringstream BurgersDomain::Print(Time time) const
+{
+    return Mesh.Print(time);
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <sstream>
+#include "aligned.h"
+#include "mesh.h"
+
+// Inviscid Burgers equation u_t + (u^2/2)_x = 0.
+// Conservative finite volume MUSCL-Hancock scheme with a TVD slope limiter
+// and the exact Godunov flux. Every cell update needs two cells on each side.
+const size_t BurgersGhostCells = 2;
+
+// Target Courant number max|u| dt / h of the time step controller.
+const double BurgersCourant = 0.8;
+
+enum class Limiter
+{
+    Minmod,
+    Superbee
+};
+
+// Computes count cells of the MUSCL-Hancock scheme. u_k and u_k1 point to the first computed cell,
+// u_k[-2, -1] and u_k[count, count + 1] must be valid. slope (count + 2 values) and flux (count + 1 values)
+// are scratch arrays.
+void ComputeCellsBurgersTvd(const double* u_k, double* u_k1, double* slope, double* flux,
+                            double dtOverH, ::Limiter limiter, size_t count);
+
+// Max |f'(u)| = max |u| over count cells.
+double ComputeBurgersMaxSpeed(const double* u, size_t count);
+
+class BurgersDomain
+{
+private:
+    double xLeft;
+    ::Mesh Mesh;
+    ::Limiter Limiter;
+
+    AlignedLayer Slope;
+    AlignedLayer Flux;
+
+public:
+    BurgersDomain(const size_t meshSize, const double x1, ::Limiter limiter);
+
+    void SetSpatialBoundary();
+
+    // Max speed of the previous time layer on this domain.
+    double GetMaxSpeed() const;
+
+    void ComputeCells(double dt);
+
+    // Start ghost cells are set from ComputeTimeBoundary(), stop ones are transmissive.
+    void SetTimeBoundary(double t);
+    void ApproximateTimeBoundary();
+
+    // BurgersGhostCells values of the current layer that are ghost cells of the neighbours.
+    const double* GetStartInnerCells() const;
+    const double* GetStopInnerCells() const;
+
+    double* GetStartBoundary();
+    double* GetStopBoundary();
+
+    void NextTimeStep();
+
+    const ::Mesh& GetMesh() const;
+
+    std::stringstream Print(Time time) const;
+};
\ No newline at end of file
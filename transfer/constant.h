@@ -19,6 +19,14 @@
 const double a = 1; // m/sec
 const double Amplitude = 1;
 
+// Velocity field a(x, t) = ComputeVelocityProfile(x) * ComputeVelocityModulation(t).
+// a is the reference velocity used for the mesh and the Courant number.
+// When the modulation is constant only the spatial profile is precomputed once.
+const bool VelocityTimeDependent = false;
+
+// ComputeGeneratorFunction() == 0, the source term is skipped.
+const bool ZeroGenerator = true;
+
 const double PeriodT = 1; // sec
 const double PeriodX = a*PeriodT; // m
 
@@ -2,88 +2,137 @@
 #include "functions.h"
 #include "domain.h"
 
-Domain::Domain(const size_t meshSize, const double x1, ::Direction direction) :
+Domain::Domain(const size_t meshSize, const double x1, const double h, const double tau) :
     xLeft(x1),
-    Mesh(meshSize, xLeft),
-    Direction(direction)
+    H(h),
+    Tau(tau),
+    Mesh(meshSize, xLeft, H),
+    Co(meshSize),
+    CoFace(meshSize),
+    Source(meshSize),
+    VelocityScale(1),
+    VelocityTime(-1),
+    SourceTime(-1)
 {
     SetSpatialBoundary();
+    SetVelocityField();
 }
 
 double Domain::GetXRight()
 {
-    return xLeft + h * (Mesh.MeshSize + 1);
+    return xLeft + H * (Mesh.MeshSize + 1);
+}
+
+double Domain::GetVelocityScale(double t)
+{
+    if (VelocityTimeDependent && t != VelocityTime)
+    {
+        VelocityScale = ComputeVelocityModulation(t - Tau / 2);
+        VelocityTime  = t;
+    }
+
+    return VelocityScale;
+}
+
+void Domain::SetSource(double t)
+{
+    if (ZeroGenerator || t == SourceTime)
+        return;
+
+    double* f_k = Source.Inner();
+    double x = xLeft + H;
+    for (size_t st = 0; st < Mesh.MeshSize; st++)
+    {
+        f_k[st] = ComputeGeneratorFunction(x, t - Tau);
+        x += H;
+    }
+    SourceTime = t;
 }
 
 void Domain::ComputeStartBoundary(double t)
 {
+    double scale   = GetVelocityScale(t);
+    double co      = Co.Inner()[0] * scale;
     double u_k_mm1 = Mesh.GetStartBoundaryValue(Time::Prev);
     double u_k_m   = Mesh.GetValue(0, Time::Prev);
     double u_k_mp1 = Mesh.GetValue(1, Time::Prev);
-    double f_k_m   = ComputeGeneratorFunction(xLeft + h, t - tau);
+    double f_k_m   = ComputeGeneratorFunction(xLeft + H, t - Tau);
     
-    double value = ComputeCellCentral4Points(u_k_mm1, u_k_m, u_k_mp1, f_k_m);
+    double value = ComputeCellCentral4Points(co, CoFace.Inner()[-1] * scale, CoFace.Inner()[0] * scale, Tau,
+                                             u_k_mm1, u_k_m, u_k_mp1, f_k_m);
     Mesh.SetValue(0, Time::Curr, value);
 }
 
 void Domain::ComputeStopBoundary(double t)
 {
+    double scale   = GetVelocityScale(t);
+    double co      = Co.Inner()[Mesh.MeshSize - 1] * scale;
     double u_k_mm1 = Mesh.GetValue(Mesh.MeshSize - 2, Time::Prev);
     double u_k_m   = Mesh.GetValue(Mesh.MeshSize - 1, Time::Prev);
     double u_k_mp1 = Mesh.GetStopBoundaryValue(Time::Prev);
-    double f_k_m   = ComputeGeneratorFunction(GetXRight() - h, t - tau);
+    double f_k_m   = ComputeGeneratorFunction(GetXRight() - H, t - Tau);
     
-    double value = ComputeCellCentral4Points(u_k_mm1, u_k_m, u_k_mp1, f_k_m);
+    double value = ComputeCellCentral4Points(co, CoFace.Inner()[Mesh.MeshSize - 2] * scale,
+                                             CoFace.Inner()[Mesh.MeshSize - 1] * scale, Tau,
+                                             u_k_mm1, u_k_m, u_k_mp1, f_k_m);
     Mesh.SetValue(Mesh.MeshSize - 1, Time::Curr, value);
 }
 
+// Flops of a cell of ComputeCellsCentral4Points() and of its source term.
+static const double CellFlops = 12;
+static const double SourceFlops = 2;
+
 void Domain::ComputeInnerCells(double t)
 {
-    if (Direction == Direction::Fwd)
-    {
-        double x = xLeft + 2 * h;
-        for (size_t st = 1; st < Mesh.MeshSize - 1; st++)
-        {
-            double u_k_mm1 = Mesh.GetValue(st - 1, Time::Prev);
-            double u_k_m   = Mesh.GetValue(st,     Time::Prev);
-            double u_k_mp1 = Mesh.GetValue(st + 1, Time::Prev);
-            double f_k_m   = ComputeGeneratorFunction(x, t - tau);
-            double value   = ComputeCellCentral4Points(u_k_mm1, u_k_m, u_k_mp1, f_k_m);
-            Mesh.SetValue(st, Time::Curr, value);
-            x += h;
-        }
-    }
-    else
-    {
-        double x = GetXRight() - 2 * h;
-        for (int st = Mesh.MeshSize - 2; st >= 1; st--)
-        {
-            double u_k_mm1 = Mesh.GetValue(st - 1, Time::Prev);
-            double u_k_m   = Mesh.GetValue(st,     Time::Prev);
-            double u_k_mp1 = Mesh.GetValue(st + 1, Time::Prev);
-            double f_k_m   = ComputeGeneratorFunction(x, t - tau);
-            double value   = ComputeCellCentral4Points(u_k_mm1, u_k_m, u_k_mp1, f_k_m);
-            Mesh.SetValue(st, Time::Curr, value);
-            x -= h;
-        }
-    }
+    if (Mesh.MeshSize < 3)
+        return;
+
+    SetSource(t);
+
+    const double* f_k = ZeroGenerator ? nullptr : Source.Inner() + 1;
+
+    ComputeCellsCentral4Points(Mesh.GetLayer(Time::Prev) + 1, Mesh.GetLayer(Time::Curr) + 1,
+                               Co.Inner() + 1, CoFace.Inner() + 1, GetVelocityScale(t), Tau,
+                               f_k, Mesh.MeshSize - 2);
+}
+
+double Domain::GetInnerCellsFlops() const
+{
+    if (Mesh.MeshSize < 3)
+        return 0;
+
+    return (CellFlops + (ZeroGenerator ? 0 : SourceFlops)) * static_cast<double>(Mesh.MeshSize - 2);
 }
 
 void Domain::SetSpatialBoundary()
 {
     double value = ComputeSpatialBoundary(xLeft);
     Mesh.SetStartBoundaryValue(Time::Prev, value);
-    double x = xLeft + h;
+    double x = xLeft + H;
     for (size_t st = 0; st < Mesh.MeshSize; st++)
     {
         value = ComputeSpatialBoundary(x);
         Mesh.SetValue(st, Time::Prev, value);
-        x += h;
+        x += H;
     }
     value = ComputeSpatialBoundary(x);
     Mesh.SetStopBoundaryValue(Time::Prev, value);
 }
 
+void Domain::SetVelocityField()
+{
+    // Start from the start boundary cell and its right face.
+    double* co     = Co.Inner() - 1;
+    double* coFace = CoFace.Inner() - 1;
+    double x = xLeft;
+    for (size_t st = 0; st < Mesh.MeshSize + 2; st++)
+    {
+        co[st]     = ComputeVelocityProfile(x) * Tau / H;
+        coFace[st] = ComputeVelocityProfile(x + H / 2) * Tau / H;
+        x += H;
+    }
+}
+
 void Domain::SetTimeBoundary(double t)
 {
     double value = ComputeTimeBoundary(t);
@@ -92,10 +141,11 @@ void Domain::SetTimeBoundary(double t)
 
 void Domain::ApproximateTimeBoundary(double t)
 {
+    double co      = Co.Inner()[Mesh.MeshSize] * GetVelocityScale(t);
     double u_k_mm1 = Mesh.GetValue(Mesh.MeshSize - 1, Time::Prev);
     double u_k_m   = Mesh.GetStopBoundaryValue(Time::Prev);
-    double f_k_m   = ComputeGeneratorFunction(GetXRight(), t - tau);
-    double value   = ComputeCellLeftCorner(u_k_mm1, u_k_m, f_k_m);
+    double f_k_m   = ComputeGeneratorFunction(GetXRight(), t - Tau);
+    double value   = ComputeCellLeftCorner(co, Tau, u_k_mm1, u_k_m, f_k_m);
     Mesh.SetStopBoundaryValue(Time::Curr, value);
 }
 
@@ -132,14 +182,4 @@ const ::Mesh& Domain::GetMesh() const
 std::stringstream Domain::Print(Time time) const
 {
     return Mesh.Print(time);
-}
-
-const Mesh::MeshCell* Domain::GetLeftCell() const
-{
-    return Mesh.GetStartCell();
-}
-
-const Mesh::MeshCell* Domain::GetRightCell() const
-{
-    return Mesh.GetStopCell();
 }
\ No newline at end of file
@@ -2,27 +2,48 @@
 
 #include <cstddef>
 #include <sstream>
+#include "aligned.h"
 #include "mesh.h"
 
 class Domain
 {
 private:
     double xLeft;
+    // Mesh steps.
+    const double H;
+    const double Tau;
     ::Mesh Mesh;
-    ::Direction Direction;
+
+    // Courant numbers ComputeVelocityProfile(x) * Tau / H of the cells and of their right faces x + H/2.
+    // Same layout as the mesh layers, boundary cells included.
+    AlignedLayer Co;
+    AlignedLayer CoFace;
+    // Source term f^k_m, filled only if !ZeroGenerator.
+    AlignedLayer Source;
+
+    // ComputeVelocityModulation() in the middle of the time step, refreshed once per time step.
+    double VelocityScale;
+    double VelocityTime;
+    double SourceTime;
 
 private:
     double GetXRight();
 
+    double GetVelocityScale(double t);
+    void SetSource(double t);
+
 public:
-    Domain(const size_t meshSize, const double x1, ::Direction direction);
+    Domain(const size_t meshSize, const double x1, const double h, const double tau);
 
     void ComputeStartBoundary(double t);
     void ComputeStopBoundary(double t);
 
     void ComputeInnerCells(double t);
+    // Flops of a ComputeInnerCells() call.
+    double GetInnerCellsFlops() const;
 
     void SetSpatialBoundary();
+    void SetVelocityField();
 
     void SetTimeBoundary(double t);
     void ApproximateTimeBoundary(double t);
@@ -33,9 +54,6 @@ public:
     void SetStartBoundary(double value);
     void SetStopBoundary(double value);
 
-    const Mesh::MeshCell* GetLeftCell() const;
-    const Mesh::MeshCell* GetRightCell() const;
-
     void NextTimeStep();
 
     const ::Mesh& GetMesh() const;
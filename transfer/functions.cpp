@@ -33,22 +33,79 @@ double ComputeSpatialBoundary(__attribute__((unused)) double x)
     return Amplitude * sin(M_PI * 2 * x / PeriodX);
 }
 
-double ComputeCellCentral3Points(double u_k_mm1, double u_k_mp1, double f_k_m)
+double ComputeVelocityProfile(__attribute__((unused)) double x)
+{
+    // Homogeneous medium.
+    return a; // m/sec
+}
+
+double ComputeVelocityModulation(__attribute__((unused)) double t)
+{
+    // Stationary medium. Set VelocityTimeDependent in constant.h for the time dependent one.
+    return 1;
+}
+
+double ComputeCellCentral3Points(double co, double tau, double u_k_mm1, double u_k_mp1, double f_k_m)
 {
     // 1/tau (u^{k+1}_m - 1/2 (u^k_{m+1} + u^k_{m-1})) + a 1/2h (u^k_{m+1} - u^k_{m-1}) = f^k_m.
-    double value = (f_k_m - a * 1/(2*h) * (u_k_mp1 - u_k_mm1)) * tau + 1/2 * (u_k_mp1 + u_k_mm1);
+    // co = a tau / h.
+    double value = f_k_m * tau - co/2 * (u_k_mp1 - u_k_mm1) + 0.5 * (u_k_mp1 + u_k_mm1);
     return value;
 }
 
-double ComputeCellCentral4Points(double u_k_mm1, double u_k_m, double u_k_mp1, double f_k_m)
+double ComputeCellCentral4Points(double co, double coLeft, double coRight, double tau,
+                                 double u_k_mm1, double u_k_m, double u_k_mp1, double f_k_m)
 {
-    // 1/tau (u^{k+1}_m - u^k_{m}) + a 1/2h (u^k_{m+1} - u^k_{m-1}) - a^2 * tau /2h^2 (u^k_{m+1} - 2 u^k_m + u^k_{m-1}) = f^k_m.
-    double value = (f_k_m - a/(2*h) * (u_k_mp1 - u_k_mm1) + a*a * tau/(2*h*h) * (u_k_mp1 - 2 * u_k_m + u_k_mm1)) * tau + u_k_m;
+    // Lax-Wendroff scheme for u_t + a(x, t) u_x = f, u_tt = a (a u_x)_x - a_t u_x + ...:
+    // 1/tau (u^{k+1}_m - u^k_{m}) + a_m 1/2h (u^k_{m+1} - u^k_{m-1})
+    //     - a_m tau /2h^2 (a_{m+1/2} (u^k_{m+1} - u^k_m) - a_{m-1/2} (u^k_m - u^k_{m-1})) = f^k_m.
+    // co = a_m tau / h, coLeft and coRight are the Courant numbers of the faces m -+ 1/2.
+    // a is taken at t^k + tau/2, so the a_t u_x term is in the first difference.
+    double value = f_k_m * tau - co/2 * (u_k_mp1 - u_k_mm1)
+                 + co/2 * (coRight * (u_k_mp1 - u_k_m) - coLeft * (u_k_m - u_k_mm1)) + u_k_m;
     return value;
 }
 
-double ComputeCellLeftCorner(double u_k_mm1, double u_k_m, double f_k_m)
+double ComputeCellLeftCorner(double co, double tau, double u_k_mm1, double u_k_m, double f_k_m)
 {
     // 1/tau (u^{k+1}_m - u^k_m) + a/h (u^k_m - u^k_{m-1}) = f^k_m.
-    return (f_k_m - a * 1/h * (u_k_m - u_k_mm1)) * tau + u_k_m;
+    // co = a tau / h.
+    return f_k_m * tau - co * (u_k_m - u_k_mm1) + u_k_m;
+}
+
+void ComputeCellsCentral4Points(const double* __restrict__ u_k, double* __restrict__ u_k1,
+                                const double* __restrict__ co, const double* __restrict__ coFace, double scale, double tau,
+                                const double* __restrict__ f_k, size_t count)
+{
+    // Same scheme as ComputeCellCentral4Points() with a(x, t) tau / h = co[m] * scale
+    // and the face numbers coFace[m - 1] * scale, coFace[m] * scale.
+    // The loops only stream aligned arrays and are vectorized by the compiler.
+    const double halfScale  = scale / 2;
+    const double halfScale2 = scale * scale / 2;
+    const double* u_k_left    = u_k - 1;
+    const double* coFace_left = coFace - 1;
+
+    if (f_k)
+    {
+        for (size_t m = 0; m < count; m++)
+        {
+            double u_k_mm1 = u_k_left[m];
+            double u_k_m   = u_k[m];
+            double u_k_mp1 = u_k[m + 1];
+            u_k1[m] = f_k[m] * tau 
+                    - halfScale  * co[m] * (u_k_mp1 - u_k_mm1) 
+                    + halfScale2 * co[m] * (coFace[m] * (u_k_mp1 - u_k_m) - coFace_left[m] * (u_k_m - u_k_mm1)) + u_k_m;
+        }
+    }
+    else
+    {
+        for (size_t m = 0; m < count; m++)
+        {
+            double u_k_mm1 = u_k_left[m];
+            double u_k_m   = u_k[m];
+            double u_k_mp1 = u_k[m + 1];
+            u_k1[m] = - halfScale  * co[m] * (u_k_mp1 - u_k_mm1) 
+                      + halfScale2 * co[m] * (coFace[m] * (u_k_mp1 - u_k_m) - coFace_left[m] * (u_k_m - u_k_mm1)) + u_k_m;
+        }
+    }
 }
\ No newline at end of file
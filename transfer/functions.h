@@ -1,13 +1,29 @@
 #pragma once
 
+#include <cstddef>
+
 double ComputeGeneratorFunction(double x, double t);
 
 double ComputeTimeBoundary(double t);
 
 double ComputeSpatialBoundary(double x);
 
-double ComputeCellCentral4Points(double u_k_mm1, double u_k_m, double u_k_mp1, double f_k_m);
+double ComputeVelocityProfile(double x);
+
+double ComputeVelocityModulation(double t);
+
+// coLeft and coRight are the Courant numbers of the faces m - 1/2 and m + 1/2.
+double ComputeCellCentral4Points(double co, double coLeft, double coRight, double tau,
+                                 double u_k_mm1, double u_k_m, double u_k_mp1, double f_k_m);
+
+double ComputeCellCentral3Points(double co, double tau, double u_k_mm1, double u_k_mp1, double f_k_m);
 
-double ComputeCellCentral3Points(double u_k_mm1, double u_k_mp1, double f_k_m);
+double ComputeCellLeftCorner(double co, double tau, double u_k_mm1, double u_k_m, double f_k_m);
 
-double ComputeCellLeftCorner(double u_k_mm1, double u_k_m, double f_k_m);
\ No newline at end of file
+// Computes count cells of the central 4 points scheme with the variable Courant number
+// co[m] * scale. u_k and u_k1 point to the first computed cell, u_k[-1] and u_k[count] must be valid.
+// coFace[m] is the Courant number of the face m + 1/2, coFace[-1] must be valid.
+// f_k may be nullptr if there is no source term.
+void ComputeCellsCentral4Points(const double* u_k, double* u_k1,
+                                const double* co, const double* coFace, double scale, double tau,
+                                const double* f_k, size_t count);
\ No newline at end of file
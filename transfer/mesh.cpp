@@ -3,71 +3,77 @@
 #include <memory>
 #include <sstream>
 
-#include "constant.h"
 #include "mesh.h"
 
-Mesh::Mesh(size_t innerCellsCount, double xLeft) :
+Mesh::Mesh(size_t innerCellsCount, double xLeft, double h, size_t ghostCells) :
     MeshSize(innerCellsCount),
+    GhostCells(ghostCells),
     Type(MeshType::FirstIsPrev),
-    CellsArray(std::make_unique<MeshCell[]>(MeshSize + 2)),
-    StartBoundary(CellsArray.get() + 0),
-    InnerCells(StartBoundary + 1),
-    StopBoundary(InnerCells + MeshSize)
+    First(MeshSize, GhostCells),
+    Second(MeshSize, GhostCells),
+    X(MeshSize, GhostCells)
 {
-    StartBoundary->x = xLeft;
-    double x = xLeft + h;
-    for (size_t st = 0; st < innerCellsCount; st++)
-    {
-        InnerCells[st].x = x;
-        x += h;
-    }
-    StopBoundary->x = x;
+    // xLeft is the coordinate of the start boundary cell [-1].
+    double* x = X.Inner() - GhostCells;
+    double x0 = xLeft - h * (GhostCells - 1);
+    for (size_t st = 0; st < innerCellsCount + 2 * GhostCells; st++)
+        x[st] = x0 + h * st;
 }
 
-double& Mesh::MeshCell::GetValue(Time time, MeshType type)
+double* Mesh::GetLayer(Time time)
 {
     //  CellType |    MeshType     | Result | Sum % 2
     //  Prev = 0 | FirstIsPrev = 0 | First  |    0
     //  Prev = 0 | FirstIsCurr = 1 | Second |    1
     //  Curr = 1 | FirstIsPrev = 0 | Second |    1
     //  Curr = 1 | FirstIsCurr = 1 | First  |    0
-    bool second = (static_cast<int>(time) + static_cast<int>(type)) % 2;
+    bool second = (static_cast<int>(time) + static_cast<int>(Type)) % 2;
     if (second)
-        return Second;
+        return Second.Inner();
     else
-        return First;
+        return First.Inner();
+}
+
+const double* Mesh::GetLayer(Time time) const
+{
+    return const_cast<Mesh*>(this)->GetLayer(time);
+}
+
+const double* Mesh::GetX() const
+{
+    return X.Inner();
 }
 
 double Mesh::GetValue(size_t xIndex, Time time) const
 {
     assert(xIndex < MeshSize);
-    return InnerCells[xIndex].GetValue(time, Type);
+    return GetLayer(time)[xIndex];
 }
 
 void Mesh::SetValue(size_t xIndex, Time time, double value)
 {
     assert(xIndex < MeshSize);
-    InnerCells[xIndex].GetValue(time, Type) = value;
+    GetLayer(time)[xIndex] = value;
 }
 
 double Mesh::GetStartBoundaryValue(Time time) const
 {
-    return StartBoundary->GetValue(time, Type);
+    return GetLayer(time)[-1];
 }
 
 void Mesh::SetStartBoundaryValue(Time time, double value)
 {
-    StartBoundary->GetValue(time, Type) = value;
+    GetLayer(time)[-1] = value;
 }
 
 double Mesh::GetStopBoundaryValue(Time time) const
 {
-    return StopBoundary->GetValue(time, Type);
+    return GetLayer(time)[MeshSize];
 }
 
 void Mesh::SetStopBoundaryValue(Time time, double value)
 {
-    StopBoundary->GetValue(time, Type) = value;
+    GetLayer(time)[MeshSize] = value;
 }
 
 void Mesh::NextTimeStep()
@@ -84,21 +90,6 @@ void Mesh::NextTimeStep()
     }
 }
 
-const Mesh::MeshCell* Mesh::GetInnerCells() const
-{
-    return InnerCells;
-}
-
-const Mesh::MeshCell* Mesh::GetStartCell() const
-{
-    return StartBoundary;
-}
-
-const Mesh::MeshCell* Mesh::GetStopCell() const
-{
-    return StopBoundary;
-}
-
 static void Align(std::stringstream& str, size_t alignLen)
 {
     for (size_t st = 0; st < alignLen; st++)
@@ -158,10 +149,13 @@ std::stringstream Mesh::Print(Time time) const
 
     PrintColumn(cap, value, x, "", "value", "x");
     
-    PrintColumn(cap, value, x, "LB", StartBoundary->GetValue(time, Type), StartBoundary->x);
+    const double* layer = GetLayer(time);
+    const double* coords = GetX();
+
+    PrintColumn(cap, value, x, "LB", layer[-1], coords[-1]);
     for (size_t st = 0; st < MeshSize; st++)
-        PrintColumn(cap, value, x, "", InnerCells[st].GetValue(time, Type), InnerCells[st].x);
-    PrintColumn(cap, value, x, "RB", StopBoundary->GetValue(time, Type), StopBoundary->x);
+        PrintColumn(cap, value, x, "", layer[st], coords[st]);
+    PrintColumn(cap, value, x, "RB", layer[MeshSize], coords[MeshSize]);
 
     if (time == Time::Curr)
         cap << "Time == current\n";
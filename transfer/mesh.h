@@ -4,6 +4,8 @@
 #include <sstream>
 #include <memory>
 
+#include "aligned.h"
+
 enum class Time
 {
     Prev = 0,
@@ -25,26 +27,20 @@ public:
         FirstIsCurr = 1
     };
 
-    struct MeshCell
-    {
-        double x;
-        double First;
-        double Second;
-
-        double& GetValue(Time time, MeshType type);
-    };
-
     const size_t MeshSize;
+    const size_t GhostCells;
 
 private:
     MeshType  Type;
-    std::unique_ptr<MeshCell[]> CellsArray;
-    MeshCell* const StartBoundary;
-    MeshCell* const InnerCells;
-    MeshCell* const StopBoundary;
+    // Structure of arrays: two time layers and coordinates.
+    // Boundary (ghost) cells are stored at [-GhostCells, -1] and [MeshSize, MeshSize + GhostCells - 1]
+    // of every array. The start and stop boundary values are the nearest ones [-1] and [MeshSize].
+    AlignedLayer First;
+    AlignedLayer Second;
+    AlignedLayer X;
 
 public:
-    Mesh(size_t meshSize, double xLeft);
+    Mesh(size_t meshSize, double xLeft, double h, size_t ghostCells = 1);
 
     double GetValue(size_t xIndex, Time time) const;
 
@@ -60,9 +56,10 @@ public:
 
     void NextTimeStep();
 
-    const MeshCell* GetInnerCells() const;
-    const MeshCell* GetStartCell() const;
-    const MeshCell* GetStopCell() const;
+    double* GetLayer(Time time);
+    const double* GetLayer(Time time) const;
+
+    const double* GetX() const;
 
     std::stringstream Print(Time time) const;
 
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cmath>
+
+#include "constant.h"
+#include "functions.h"
+#include "query.h"
+
+// Index of the full mesh cell in the layer arrays, whose start boundary is [-1].
+static inline double& At(AlignedLayer& layer, size_t cell)
+{
+    return (layer.Inner() - 1)[cell];
+}
+
+static size_t GetTimeIndex(double t, size_t timeSteps)
+{
+    double index = std::round(t / tau);
+    if (index < 0)
+        return 0;
+    return std::min(static_cast<size_t>(index), timeSteps);
+}
+
+static size_t GetXIndex(double x, size_t cellsCount)
+{
+    double index = std::round(x / h);
+    if (index < 0)
+        return 0;
+    return std::min(static_cast<size_t>(index), cellsCount - 1);
+}
+
+DependenceQuery::DependenceQuery() :
+    CellsCount(MeshXPoints + 2),
+    TimeSteps(static_cast<size_t>(std::floor(T / tau + 1e-9))),
+    First(MeshXPoints),
+    Second(MeshXPoints),
+    Prev(&First),
+    Curr(&Second),
+    Co(MeshXPoints),
+    CoFace(MeshXPoints),
+    Source(MeshXPoints),
+    CellsComputed(0)
+{
+    for (size_t st = 0; st < CellsCount; st++)
+    {
+        At(Co, st)     = ComputeVelocityProfile(h * st) * tau / h;
+        At(CoFace, st) = ComputeVelocityProfile(h * st + h / 2) * tau / h;
+    }
+}
+
+void DependenceQuery::SetIntervals(std::vector<Interval>& intervals, const std::vector<size_t>& xIndices,
+                                   const std::vector<size_t>& tIndices, size_t timeLayer) const
+{
+    intervals.clear();
+    for (size_t st = 0; st < xIndices.size(); st++)
+    {
+        if (tIndices[st] < timeLayer)
+            continue;
+
+        size_t width = tIndices[st] - timeLayer;
+        size_t start = xIndices[st] > width ? xIndices[st] - width : 0;
+        size_t stop  = std::min(xIndices[st] + width, CellsCount - 1);
+        intervals.push_back({ start, stop });
+    }
+
+    // Merge overlapping and adjacent cones.
+    std::sort(intervals.begin(), intervals.end(),
+              [](const Interval& left, const Interval& right) { return left.Start < right.Start; });
+
+    size_t merged = 0;
+    for (size_t st = 1; st < intervals.size(); st++)
+    {
+        if (intervals[st].Start <= intervals[merged].Stop + 1)
+            intervals[merged].Stop = std::max(intervals[merged].Stop, intervals[st].Stop);
+        else
+            intervals[++merged] = intervals[st];
+    }
+    if (!intervals.empty())
+        intervals.resize(merged + 1);
+}
+
+void DependenceQuery::ComputeSpatialBoundary(const Interval& interval)
+{
+    for (size_t st = interval.Start; st <= interval.Stop; st++)
+        At(*Curr, st) = ::ComputeSpatialBoundary(h * st);
+
+    CellsComputed += interval.Stop - interval.Start + 1;
+}
+
+void DependenceQuery::ComputeInterval(const Interval& interval, double t)
+{
+    // Same cell formulas as Domain.
+    const double scale = VelocityTimeDependent ? ComputeVelocityModulation(t - tau / 2) : 1;
+
+    size_t start = interval.Start;
+    size_t stop  = interval.Stop;
+
+    if (start == 0)
+    {
+        At(*Curr, 0) = ComputeTimeBoundary(t);
+        start++;
+    }
+
+    if (stop == CellsCount - 1)
+    {
+        double co      = At(Co, stop) * scale;
+        double f_k_m   = ComputeGeneratorFunction(h * stop, t - tau);
+        At(*Curr, stop) = ComputeCellLeftCorner(co, tau, At(*Prev, stop - 1), At(*Prev, stop), f_k_m);
+        stop--;
+    }
+
+    if (start <= stop)
+    {
+        const double* f_k = nullptr;
+        if (!ZeroGenerator)
+        {
+            for (size_t st = start; st <= stop; st++)
+                At(Source, st) = ComputeGeneratorFunction(h * st, t - tau);
+            f_k = &At(Source, start);
+        }
+
+        ComputeCellsCentral4Points(&At(*Prev, start), &At(*Curr, start),
+                                   &At(Co, start), &At(CoFace, start), scale, tau,
+                                   f_k, stop - start + 1);
+    }
+
+    CellsComputed += interval.Stop - interval.Start + 1;
+}
+
+void DependenceQuery::Compute(std::vector<PointQuery>& queries)
+{
+    CellsComputed = 0;
+    if (queries.empty())
+        return;
+
+    std::vector<size_t> xIndices(queries.size());
+    std::vector<size_t> tIndices(queries.size());
+    size_t maxTimeIndex = 0;
+    for (size_t st = 0; st < queries.size(); st++)
+    {
+        xIndices[st] = GetXIndex(queries[st].x, CellsCount);
+        tIndices[st] = GetTimeIndex(queries[st].t, TimeSteps);
+        maxTimeIndex = std::max(maxTimeIndex, tIndices[st]);
+    }
+
+    std::vector<Interval> intervals;
+    intervals.reserve(queries.size());
+
+    for (size_t timeLayer = 0; timeLayer <= maxTimeIndex; timeLayer++)
+    {
+        std::swap(Prev, Curr);
+
+        SetIntervals(intervals, xIndices, tIndices, timeLayer);
+        for (const Interval& interval : intervals)
+        {
+            if (timeLayer == 0)
+                ComputeSpatialBoundary(interval);
+            else
+                ComputeInterval(interval, tau * timeLayer);
+        }
+
+        for (size_t st = 0; st < queries.size(); st++)
+        {
+            if (tIndices[st] == timeLayer)
+                queries[st].Value = At(*Curr, xIndices[st]);
+        }
+    }
+}
+
+size_t DependenceQuery::GetCellsComputed() const
+{
+    return CellsComputed;
+}
+
+size_t DependenceQuery::GetFullCellsCount(const std::vector<PointQuery>& queries) const
+{
+    size_t maxTimeIndex = 0;
+    for (const PointQuery& query : queries)
+        maxTimeIndex = std::max(maxTimeIndex, GetTimeIndex(query.t, TimeSteps));
+    return CellsCount * (maxTimeIndex + 1);
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "aligned.h"
+
+// Value of the solution at the point (x, t) of the mesh.
+struct PointQuery
+{
+    double x;
+    double t;
+    double Value;
+};
+
+// Computes the solution only inside the union of the backward domains of dependence of the queries.
+// The central 4 points scheme uses cells m - 1, m, m + 1 of the previous time layer,
+// so a point (m, k) depends on cells [m - (k - j), m + (k - j)] of the layer j.
+// Layer j is computed only on the merged intervals of these trapezoids.
+class DependenceQuery
+{
+private:
+    struct Interval
+    {
+        size_t Start;
+        size_t Stop;
+    };
+
+    // Cells of the full mesh: start boundary 0, inner cells [1, MeshXPoints], stop boundary MeshXPoints + 1.
+    const size_t CellsCount;
+    const size_t TimeSteps;
+
+    // Two time layers, Prev and Curr are swapped every time step.
+    AlignedLayer First;
+    AlignedLayer Second;
+    AlignedLayer* Prev;
+    AlignedLayer* Curr;
+    // Courant numbers of the cells and of their right faces.
+    AlignedLayer Co;
+    AlignedLayer CoFace;
+    AlignedLayer Source;
+
+    size_t CellsComputed;
+
+private:
+    void SetIntervals(std::vector<Interval>& intervals, const std::vector<size_t>& xIndices,
+                      const std::vector<size_t>& tIndices, size_t timeLayer) const;
+
+    void ComputeSpatialBoundary(const Interval& interval);
+    void ComputeInterval(const Interval& interval, double t);
+
+public:
+    DependenceQuery();
+
+    // Queries are rounded to the nearest mesh point.
+    void Compute(std::vector<PointQuery>& queries);
+
+    size_t GetCellsComputed() const;
+
+    // Cells computed by the full solver up to the latest query time layer.
+    size_t GetFullCellsCount(const std::vector<PointQuery>& queries) const;
+};
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include <cassert>
+
+#include "../common/counters.h"
+#include "double.h"
+#include "solver.h"
+
+const int SyncBoundary    = 1;
+const int SyncWrite       = 2;
+const int SyncEndBoundary = 3;
+
+static int GetCommRank(MPI_Comm comm)
+{
+    int procRank = 0;
+    MPI_Comm_rank(comm, &procRank);
+    return procRank;
+}
+
+static int GetCommSize(MPI_Comm comm)
+{
+    int procsCount = 0;
+    MPI_Comm_size(comm, &procsCount);
+    return procsCount;
+}
+
+// All ranks get MeshXPoints / procsCount cells, the last one also gets the remainder.
+static size_t GetSliceSize(const TransferConfig& config, int procRank, int procsCount)
+{
+    size_t indMeshSize = config.GetMeshXPoints() / procsCount;
+    if (procRank == procsCount - 1)
+        return indMeshSize + config.GetMeshXPoints() - indMeshSize * procsCount;
+    return indMeshSize;
+}
+
+TransferSolver::TransferSolver(MPI_Comm comm, const TransferConfig& config) :
+    Comm(comm),
+    Config(config),
+    ProcRank(GetCommRank(comm)),
+    ProcsCount(GetCommSize(comm)),
+    Offset(ProcRank * (Config.GetMeshXPoints() / ProcsCount)),
+    Direction(ProcRank % 2 == 0 ? Direction::Inv : Direction::Fwd),
+    Domain(GetSliceSize(Config, ProcRank, ProcsCount), Offset * Config.GetH(), Config.GetH(), Config.GetTau()),
+    Time(0),
+    TimeStep(0)
+{
+}
+
+void TransferSolver::Step(size_t count)
+{
+    // Synchronization plan:
+    // --> = send
+    // ->x = receive
+
+    //  0 | 1 | 2 | 3 | 4 | 5
+    // Inv Fwd Inv Fwd Inv Fwd
+
+    // -->     -->     -->
+    //    ->x      ->x     ->x
+    //    <--      <--     <--
+    // x<-     x<-     x<-
+    
+    //    -->      -->
+    //         ->x     ->x
+    //         <--     <--
+    //    x<-      x<-
+
+    for (size_t step = 0; step < count; step++)
+    {
+        MPI_Request startRequest = MPI_REQUEST_NULL;
+        MPI_Request stopRequest  = MPI_REQUEST_NULL;
+
+        double startCellSender   = 0;
+        double stopCellSender    = 0;
+
+        double startCellReceiver = 0;
+        double stopCellReceiver  = 0;
+
+        double t = Time + Config.GetTau();
+
+        if (Direction == Direction::Fwd)
+            Domain.ComputeStartBoundary(t);
+        else
+            Domain.ComputeStopBoundary(t);
+
+        if (ProcRank % 2 == 0 && ProcRank + 1 < ProcsCount)
+        {
+            stopCellSender = Domain.GetStopInnerCell();
+            MPI_Isend(&stopCellSender, 1, MPI_DOUBLE, ProcRank + 1, SyncBoundary, Comm, &stopRequest);
+        }
+
+        Domain.ComputeInnerCells(t);
+
+        if (Direction == Direction::Fwd)
+            Domain.ComputeStopBoundary(t);
+        else
+            Domain.ComputeStartBoundary(t);
+
+        if (ProcRank == 0)
+            Domain.SetTimeBoundary(t);
+
+        if (ProcRank == ProcsCount - 1)
+            Domain.ApproximateTimeBoundary(t);
+
+        if (ProcRank % 2 == 1)
+        {
+            MPI_Recv(&startCellReceiver, 1, MPI_DOUBLE, ProcRank - 1, SyncBoundary, Comm, MPI_STATUS_IGNORE);
+            Domain.SetStartBoundary(startCellReceiver);
+
+            startCellSender = Domain.GetStartInnerCell();
+            MPI_Isend(&startCellSender, 1, MPI_DOUBLE, ProcRank - 1, SyncBoundary, Comm, &startRequest);
+
+            if (ProcRank + 1 < ProcsCount)
+            {
+                stopCellSender = Domain.GetStopInnerCell();
+                MPI_Isend(&stopCellSender, 1, MPI_DOUBLE, ProcRank + 1, SyncBoundary, Comm, &stopRequest);
+
+                MPI_Recv(&stopCellReceiver, 1, MPI_DOUBLE, ProcRank + 1, SyncBoundary, Comm, MPI_STATUS_IGNORE);
+                Domain.SetStopBoundary(stopCellReceiver);
+            }
+        }
+        else
+        {
+            if (ProcRank + 1 < ProcsCount)
+            {
+                MPI_Recv(&stopCellReceiver, 1, MPI_DOUBLE, ProcRank + 1, SyncBoundary, Comm, MPI_STATUS_IGNORE);
+                Domain.SetStopBoundary(stopCellReceiver);
+            }
+
+            if (ProcRank - 1 > 0)
+            {
+                MPI_Recv(&startCellReceiver, 1, MPI_DOUBLE, ProcRank - 1, SyncBoundary, Comm, MPI_STATUS_IGNORE);
+                Domain.SetStartBoundary(startCellReceiver);
+
+                startCellSender = Domain.GetStartInnerCell();
+                MPI_Ssend(&startCellSender, 1, MPI_DOUBLE, ProcRank - 1, SyncBoundary, Comm);
+            }
+        }
+
+        MPI_Wait(&startRequest, MPI_STATUS_IGNORE);
+        MPI_Wait(&stopRequest, MPI_STATUS_IGNORE);
+
+        Domain.NextTimeStep();
+        Time = t;
+        TimeStep++;
+
+        for (const Callback& callback : Callbacks)
+        {
+            if (TimeStep % callback.Interval == 0)
+                callback.Function(*this);
+        }
+    }
+}
+
+void TransferSolver::RunUntil(double t)
+{
+    // One region for all steps, a region per step would mostly count its own syscalls.
+    CounterRegion region("TimeSteps");
+    while (Double::IsLessEqual(Time + Config.GetTau(), t))
+    {
+        Step();
+        region.AddFlops(Domain.GetInnerCellsFlops());
+    }
+}
+
+void TransferSolver::AddCallback(size_t interval, StepCallback function)
+{
+    assert(interval > 0);
+    Callbacks.push_back({ interval, std::move(function) });
+}
+
+double TransferSolver::GetTime() const
+{
+    return Time;
+}
+
+size_t TransferSolver::GetTimeStep() const
+{
+    return TimeStep;
+}
+
+const TransferConfig& TransferSolver::GetConfig() const
+{
+    return Config;
+}
+
+MPI_Comm TransferSolver::GetComm() const
+{
+    return Comm;
+}
+
+std::span<const double> TransferSolver::GetValues() const
+{
+    // After NextTimeStep() the latest layer is the previous one.
+    const Mesh& mesh = Domain.GetMesh();
+    return std::span<const double>(mesh.GetLayer(Time::Prev), mesh.MeshSize);
+}
+
+std::span<const double> TransferSolver::GetX() const
+{
+    const Mesh& mesh = Domain.GetMesh();
+    return std::span<const double>(mesh.GetX(), mesh.MeshSize);
+}
+
+size_t TransferSolver::GetOffset() const
+{
+    return Offset;
+}
+
+double TransferSolver::GetStartBoundaryValue() const
+{
+    return Domain.GetMesh().GetStartBoundaryValue(Time::Prev);
+}
+
+double TransferSolver::GetStopBoundaryValue() const
+{
+    return Domain.GetMesh().GetStopBoundaryValue(Time::Prev);
+}
+
+std::vector<double> TransferSolver::Gather(int root) const
+{
+    std::span<const double> values = GetValues();
+    const size_t meshXPoints = Config.GetMeshXPoints();
+
+    std::vector<int> counts;
+    std::vector<int> displs;
+    std::vector<double> fullMesh;
+    if (ProcRank == root)
+    {
+        counts.resize(ProcsCount);
+        displs.resize(ProcsCount);
+        for (int st = 0; st < ProcsCount; st++)
+        {
+            counts[st] = GetSliceSize(Config, st, ProcsCount);
+            displs[st] = 1 + st * (meshXPoints / ProcsCount);
+        }
+        fullMesh.resize(meshXPoints + 2);
+    }
+
+    MPI_Gatherv(values.data(), values.size(), MPI_DOUBLE,
+                fullMesh.data(), counts.data(), displs.data(), MPI_DOUBLE, root, Comm);
+
+    double startBoundary = GetStartBoundaryValue();
+    double stopBoundary  = GetStopBoundaryValue();
+
+    if (ProcRank == 0 && root != 0)
+        MPI_Ssend(&startBoundary, 1, MPI_DOUBLE, root, SyncWrite, Comm);
+    if (ProcRank == ProcsCount - 1 && root != ProcsCount - 1)
+        MPI_Ssend(&stopBoundary, 1, MPI_DOUBLE, root, SyncEndBoundary, Comm);
+
+    if (ProcRank == root)
+    {
+        if (root != 0)
+            MPI_Recv(&startBoundary, 1, MPI_DOUBLE, 0, SyncWrite, Comm, MPI_STATUS_IGNORE);
+        if (root != ProcsCount - 1)
+            MPI_Recv(&stopBoundary, 1, MPI_DOUBLE, ProcsCount - 1, SyncEndBoundary, Comm, MPI_STATUS_IGNORE);
+
+        fullMesh.front() = startBoundary;
+        fullMesh.back()  = stopBoundary;
+    }
+
+    return fullMesh;
+}
\ No newline at end of file
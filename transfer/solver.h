@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <vector>
+#include <mpi.h>
+
+#include "constant.h"
+#include "domain.h"
+
+// Mesh of the transfer equation. Defaults are the constants of constant.h.
+struct TransferConfig
+{
+    double X = ::X;
+    double T = ::T;
+    size_t MeshXIntervals = ::MeshXIntervals;
+    size_t MeshTPoints    = ::MeshTPoints;
+
+    size_t GetMeshXPoints() const
+    {
+        return MeshXIntervals - 1;
+    }
+
+    double GetH() const
+    {
+        return X / MeshXIntervals;
+    }
+
+    double GetTau() const
+    {
+        return T / MeshTPoints;
+    }
+};
+
+// Transfer equation solver on the ranks of a communicator.
+// Every rank owns a slice of the mesh and exchanges boundary cells with its neighbours every time step.
+// All ranks of the communicator must call Step() and RunUntil() collectively.
+class TransferSolver
+{
+public:
+    using StepCallback = std::function<void (const TransferSolver& solver)>;
+
+private:
+    struct Callback
+    {
+        size_t Interval;
+        StepCallback Function;
+    };
+
+    MPI_Comm Comm;
+    TransferConfig Config;
+    int ProcRank;
+    int ProcsCount;
+
+    // Global index of the first inner cell of the slice, the start boundary cell (x = 0) is -1.
+    size_t Offset;
+    ::Direction Direction;
+    ::Domain Domain;
+
+    double Time;
+    size_t TimeStep;
+
+    std::vector<Callback> Callbacks;
+
+public:
+    TransferSolver(MPI_Comm comm, const TransferConfig& config = {});
+
+    TransferSolver(const TransferSolver&) = delete;
+    TransferSolver& operator = (const TransferSolver&) = delete;
+
+    void Step(size_t count = 1);
+
+    // Steps while the next time layer is not after t.
+    void RunUntil(double t);
+
+    // function is called after every interval-th time step.
+    void AddCallback(size_t interval, StepCallback function);
+
+    double GetTime() const;
+    size_t GetTimeStep() const;
+
+    const TransferConfig& GetConfig() const;
+    MPI_Comm GetComm() const;
+
+    // Read-only views of the slice of the latest time layer, valid until the next step.
+    std::span<const double> GetValues() const;
+    std::span<const double> GetX() const;
+    size_t GetOffset() const;
+
+    // Boundaries of the global mesh, valid on the first and the last ranks.
+    double GetStartBoundaryValue() const;
+    double GetStopBoundaryValue() const;
+
+    // Latest time layer of the global mesh with both boundaries on the root rank, empty on other ranks.
+    std::vector<double> Gather(int root = 0) const;
+};
\ No newline at end of file
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "aligned.h"
+#include "constant.h"
+#include "system_mesh.h"
+
+// Linear hyperbolic system u_t + A u_x = 0 with constant A = Right * diag(Lambda) * Left,
+// Left = Right^{-1}. Rows of Left are the left eigenvectors, columns of Right are the right ones.
+template <size_t Fields>
+struct HyperbolicSystem
+{
+    double Lambda[Fields];
+    double Left[Fields][Fields];
+    double Right[Fields][Fields];
+};
+
+// Initial conditions: fills Fields values of the cell at x.
+using SystemInitialConditions = void (*)(double x, double* values);
+
+// The system is split into Fields scalar transfer equations for the characteristic variables
+// w = Left u, each one is advanced with the central 4 points scheme and projected back u = Right w.
+template <size_t Fields>
+class SystemDomain
+{
+private:
+    double xLeft;
+    SystemMesh<Fields> Mesh;
+    HyperbolicSystem<Fields> System;
+
+    // Characteristic variables of the previous and the current layers, structure of arrays.
+    // Cells [-SystemLanes, MeshSize + SystemLanes) are accessible.
+    std::unique_ptr<AlignedLayer> Characteristic[Fields];
+    std::unique_ptr<AlignedLayer> NextCharacteristic[Fields];
+
+private:
+    // w = Left u for all cells of the previous layer.
+    void ProjectCharacteristic()
+    {
+        const double* u = Mesh.GetLayer(Time::Prev);
+        double* w[Fields] = {};
+        for (size_t k = 0; k < Fields; k++)
+            w[k] = Characteristic[k]->Inner() - SystemLanes;
+
+        for (size_t block = 0; block < Mesh.BlocksCount; block++)
+        {
+            const double* u_block = u + block * Mesh.BlockSize;
+            for (size_t k = 0; k < Fields; k++)
+            {
+                double* w_k = w[k] + block * SystemLanes;
+                for (size_t lane = 0; lane < SystemLanes; lane++)
+                {
+                    double value = 0;
+                    for (size_t j = 0; j < Fields; j++)
+                        value += System.Left[k][j] * u_block[j * SystemLanes + lane];
+                    w_k[lane] = value;
+                }
+            }
+        }
+    }
+
+    // u = Right w for the blocks of the current layer that hold inner cells.
+    void ProjectPhysical()
+    {
+        double* u = Mesh.GetLayer(Time::Curr);
+        const double* w[Fields] = {};
+        for (size_t k = 0; k < Fields; k++)
+            w[k] = NextCharacteristic[k]->Inner() - SystemLanes;
+
+        for (size_t block = 1; block < Mesh.BlocksCount; block++)
+        {
+            double* u_block = u + block * Mesh.BlockSize;
+            for (size_t j = 0; j < Fields; j++)
+            {
+                double* u_j = u_block + j * SystemLanes;
+                for (size_t lane = 0; lane < SystemLanes; lane++)
+                {
+                    double value = 0;
+                    for (size_t k = 0; k < Fields; k++)
+                        value += System.Right[j][k] * w[k][block * SystemLanes + lane];
+                    u_j[lane] = value;
+                }
+            }
+        }
+    }
+
+    void ComputeCharacteristic(size_t k)
+    {
+        const double co = System.Lambda[k] * tau / h;
+        const double halfCo  = co / 2;
+        const double halfCo2 = co * co / 2;
+
+        const double* __restrict__ w_k  = Characteristic[k]->Inner();
+        double*       __restrict__ w_k1 = NextCharacteristic[k]->Inner();
+        const double* w_k_left = w_k - 1;
+
+        for (size_t m = 0; m < Mesh.MeshSize; m++)
+        {
+            double w_k_mm1 = w_k_left[m];
+            double w_k_m   = w_k[m];
+            double w_k_mp1 = w_k[m + 1];
+            w_k1[m] = - halfCo * (w_k_mp1 - w_k_mm1) + halfCo2 * (w_k_mp1 - 2 * w_k_m + w_k_mm1) + w_k_m;
+        }
+    }
+
+public:
+    SystemDomain(const size_t meshSize, const double x1, const HyperbolicSystem<Fields>& system) :
+        xLeft(x1),
+        Mesh(meshSize),
+        System(system)
+    {
+        for (size_t k = 0; k < Fields; k++)
+        {
+            Characteristic[k]     = std::make_unique<AlignedLayer>(meshSize, SystemLanes);
+            NextCharacteristic[k] = std::make_unique<AlignedLayer>(meshSize, SystemLanes);
+        }
+    }
+
+    void SetSpatialBoundary(SystemInitialConditions initialConditions)
+    {
+        double values[Fields] = {};
+        for (ptrdiff_t st = -1; st <= static_cast<ptrdiff_t>(Mesh.MeshSize); st++)
+        {
+            initialConditions(xLeft + h * (st + 1), values);
+            Mesh.SetCell(st, Time::Prev, values);
+        }
+    }
+
+    // Courant numbers of all characteristics must not exceed 1.
+    double GetMaxCourant() const
+    {
+        double co = 0;
+        for (size_t k = 0; k < Fields; k++)
+        {
+            double value = System.Lambda[k] * tau / h;
+            value = value > 0 ? value : -value;
+            co = value > co ? value : co;
+        }
+        return co;
+    }
+
+    void ComputeCells()
+    {
+        ProjectCharacteristic();
+
+        for (size_t k = 0; k < Fields; k++)
+            ComputeCharacteristic(k);
+
+        ProjectPhysical();
+    }
+
+    // Zero gradient boundaries of the global domain.
+    void ApproximateStartBoundary()
+    {
+        double values[Fields] = {};
+        Mesh.GetCell(0, Time::Curr, values);
+        Mesh.SetCell(-1, Time::Curr, values);
+    }
+
+    void ApproximateStopBoundary()
+    {
+        double values[Fields] = {};
+        Mesh.GetCell(Mesh.MeshSize - 1, Time::Curr, values);
+        Mesh.SetCell(Mesh.MeshSize, Time::Curr, values);
+    }
+
+    // All fields of the inner cells that are boundary cells of the neighbours,
+    // so one halo message per neighbour is sent.
+    void GetStartInnerCell(double* values) const
+    {
+        Mesh.GetCell(0, Time::Curr, values);
+    }
+
+    void GetStopInnerCell(double* values) const
+    {
+        Mesh.GetCell(Mesh.MeshSize - 1, Time::Curr, values);
+    }
+
+    void SetStartBoundary(const double* values)
+    {
+        Mesh.SetCell(-1, Time::Curr, values);
+    }
+
+    void SetStopBoundary(const double* values)
+    {
+        Mesh.SetCell(Mesh.MeshSize, Time::Curr, values);
+    }
+
+    void NextTimeStep()
+    {
+        Mesh.NextTimeStep();
+    }
+
+    const SystemMesh<Fields>& GetMesh() const
+    {
+        return Mesh;
+    }
+};
\ No newline at end of file
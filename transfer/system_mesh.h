@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include "aligned.h"
+#include "constant.h"
+#include "mesh.h"
+
+// Mesh with Fields values per cell and one boundary cell on each side.
+// Values are stored as array of structures of arrays: blocks of SystemLanes cells,
+// every block holds SystemLanes values of the first field, then of the second one and so on.
+// Per-cell small matrix products run over the lanes of a block and are vectorized.
+// Fields == 1 is the layout of the scalar Mesh.
+const size_t SystemLanes = SimdAlignment / sizeof(double);
+
+template <size_t Fields>
+class SystemMesh
+{
+public:
+    using MeshType = Mesh::MeshType;
+
+    static const size_t BlockSize = Fields * SystemLanes;
+
+    const size_t MeshSize;
+    // Blocks of a layer. Block 0 holds the start boundary cell in its last lane,
+    // inner cell 0 is lane 0 of block 1.
+    const size_t BlocksCount;
+
+private:
+    MeshType Type;
+    AlignedLayer First;
+    AlignedLayer Second;
+
+    static size_t GetIndex(ptrdiff_t xIndex, size_t field)
+    {
+        size_t cell = xIndex + SystemLanes;
+        return cell / SystemLanes * BlockSize + field * SystemLanes + cell % SystemLanes;
+    }
+
+public:
+    SystemMesh(size_t meshSize) :
+        MeshSize(meshSize),
+        BlocksCount((SystemLanes + meshSize + 1 + SystemLanes - 1) / SystemLanes),
+        Type(MeshType::FirstIsPrev),
+        First(BlocksCount * BlockSize, 0),
+        Second(BlocksCount * BlockSize, 0)
+    {
+    }
+
+    // xIndex = -1 is the start boundary, xIndex = MeshSize is the stop boundary.
+    double GetValue(ptrdiff_t xIndex, size_t field, Time time) const
+    {
+        assert(xIndex >= -1 && xIndex <= static_cast<ptrdiff_t>(MeshSize) && field < Fields);
+        return GetLayer(time)[GetIndex(xIndex, field)];
+    }
+
+    void SetValue(ptrdiff_t xIndex, size_t field, Time time, double value)
+    {
+        assert(xIndex >= -1 && xIndex <= static_cast<ptrdiff_t>(MeshSize) && field < Fields);
+        GetLayer(time)[GetIndex(xIndex, field)] = value;
+    }
+
+    // All fields of a cell.
+    void GetCell(ptrdiff_t xIndex, Time time, double* values) const
+    {
+        for (size_t field = 0; field < Fields; field++)
+            values[field] = GetValue(xIndex, field, time);
+    }
+
+    void SetCell(ptrdiff_t xIndex, Time time, const double* values)
+    {
+        for (size_t field = 0; field < Fields; field++)
+            SetValue(xIndex, field, time, values[field]);
+    }
+
+    // BlocksCount blocks of BlockSize values.
+    double* GetLayer(Time time)
+    {
+        // See Mesh::GetLayer().
+        bool second = (static_cast<int>(time) + static_cast<int>(Type)) % 2;
+        if (second)
+            return Second.Inner();
+        else
+            return First.Inner();
+    }
+
+    const double* GetLayer(Time time) const
+    {
+        return const_cast<SystemMesh*>(this)->GetLayer(time);
+    }
+
+    void NextTimeStep()
+    {
+        switch (Type)
+        {
+            case MeshType::FirstIsPrev:
+                Type = MeshType::FirstIsCurr;
+                break;
+
+            case MeshType::FirstIsCurr:
+                Type = MeshType::FirstIsPrev;
+                break;
+        }
+    }
+
+    MeshType GetType() const
+    {
+        return Type;
+    }
+};
\ No newline at end of file
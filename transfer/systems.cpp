@@ -0,0 +1,45 @@
+#include <cmath>
+
+#include "constant.h"
+#include "systems.h"
+
+HyperbolicSystem<2> MakeAcousticsSystem(double bulkModulus, double density)
+{
+    // Sound speed c and impedance Z. Characteristic speeds -c and c.
+    double c = std::sqrt(bulkModulus / density);
+    double Z = density * c;
+
+    HyperbolicSystem<2> system =
+    {
+        .Lambda = { -c, c },
+        .Left   = { { -1 / (2 * Z), 0.5 },
+                    {  1 / (2 * Z), 0.5 } },
+        .Right  = { { -Z, Z },
+                    {  1, 1 } }
+    };
+    return system;
+}
+
+HyperbolicSystem<2> MakeShallowWaterSystem(double depth, double velocity, double gravity)
+{
+    // Gravity wave speed c. Characteristic speeds U - c and U + c.
+    double c = std::sqrt(gravity * depth);
+
+    HyperbolicSystem<2> system =
+    {
+        .Lambda = { velocity - c, velocity + c },
+        .Left   = { { 0.5 / depth, -0.5 / c },
+                    { 0.5 / depth,  0.5 / c } },
+        .Right  = { {  depth, depth },
+                    { -c,     c     } }
+    };
+    return system;
+}
+
+void ComputeSystemPulse(double x, double* values)
+{
+    const double width = X / 30;
+    double dx = (x - X / 2) / width;
+    values[0] = Amplitude * std::exp(-dx * dx);
+    values[1] = 0;
+}
\ No newline at end of file
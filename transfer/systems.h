@@ -0,0 +1,13 @@
+#pragma once
+
+#include "system_domain.h"
+
+// Linear acoustics, u = (p, v): p_t + K v_x = 0, v_t + 1/rho p_x = 0.
+HyperbolicSystem<2> MakeAcousticsSystem(double bulkModulus, double density);
+
+// Shallow water linearized at depth H and velocity U, u = (eta, v):
+// eta_t + U eta_x + H v_x = 0, v_t + g eta_x + U v_x = 0.
+HyperbolicSystem<2> MakeShallowWaterSystem(double depth, double velocity, double gravity = 9.81);
+
+// Gaussian pulse of the first field in the middle of [0, X], the second field is zero.
+void ComputeSystemPulse(double x, double* values);
\ No newline at end of file
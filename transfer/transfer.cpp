@@ -3,14 +3,9 @@
 #include <sstream>
 #include <mpi.h>
 
-#include "double.h"
+#include "../common/counters.h"
 #include "constant.h"
-#include "domain.h"
-#include "mesh.h"
-
-const int SyncBoundary    = 1;
-const int SyncWrite       = 2;
-const int SyncEndBoundary = 3;
+#include "solver.h"
 
 int main(int argc, char* argv[])
 {
@@ -46,263 +41,37 @@ int main(int argc, char* argv[])
 
     MPI_Barrier(MPI_COMM_WORLD);
 
-    size_t indMeshSize = MeshXPoints / procsCount;
-    size_t meshSize = indMeshSize;
-    size_t lastMeshSize = meshSize +  MeshXPoints - meshSize * procsCount;
-    if (procRank == procsCount - 1)
-        meshSize = lastMeshSize;
+    TransferSolver solver{MPI_COMM_WORLD};
 
     {
         std::stringstream str;
-        str << "ProcRank = " << procRank << "\nMeshSize = " << meshSize << std::endl;
+        str << "ProcRank = " << procRank << "\nMeshSize = " << solver.GetValues().size() << std::endl;
         MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
     }
-    
-    Direction direction = Direction::Fwd;
-    if (procRank % 2 == 0)
-        direction = Direction::Inv;
-
-    // Synchronization plan:
-    // --> = send
-    // ->x = receive
-
-    //  0 | 1 | 2 | 3 | 4 | 5
-    // Inv Fwd Inv Fwd Inv Fwd
-
-    // -->     -->     -->
-    //    ->x      ->x     ->x
-    //    <--      <--     <--
-    // x<-     x<-     x<-
-    
-    //    -->      -->
-    //         ->x     ->x
-    //         <--     <--
-    //    x<-      x<-
-
-    double x1 = procRank * indMeshSize * h;
-    Domain domain{meshSize, x1, direction};
-    
-    MPI_Request startRequest = {};
-    MPI_Request stopRequest  = {};
-
-    double startCellSender   = 0;
-    double stopCellSender    = 0;
-
-    double startCellReceiver = 0;
-    double stopCellReceiver  = 0;
-
-    double t = tau;
 
     bool printTimeSteps = false;
 
     if (printTimeSteps)
     {
-        std::stringstream str;
-        str << "ProcRank = " << procRank << "\nBoundary conditions" << std::endl;
-        str << domain.Print(Time::Prev).str();
-        MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-    }
-
-    while (Double::IsLessEqual(t, T))
-    {
-        if (direction == Direction::Fwd)
-            domain.ComputeStartBoundary(t);
-        else
-            domain.ComputeStopBoundary(t);
-
-        if (procRank % 2 == 0 && procRank + 1 < procsCount)
-        {
-            stopCellSender = domain.GetStopInnerCell();
-
-            if (printTimeSteps)
-            {
-                std::stringstream str;
-                str << "ProcRank = " << procRank << "\nSend stopCell\n" << std::endl;
-                MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-            }
-
-            MPI_Isend(&stopCellSender, 1, MPI_DOUBLE, procRank + 1, SyncBoundary, MPI_COMM_WORLD, &stopRequest);
-
-            if (printTimeSteps)
-            {
-                std::stringstream str;
-                str << "ProcRank = " << procRank << "\nStopCell sended. Continuing...\n" << std::endl;
-                MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-            }
-        }
-
-        domain.ComputeInnerCells(t);
-
-        if (direction == Direction::Fwd)
-            domain.ComputeStopBoundary(t);
-        else
-            domain.ComputeStartBoundary(t);
-
-        if (procRank == 0)
-        {
-            if (printTimeSteps)
-            {
-                std::stringstream str;
-                str << "ProcRank = " << procRank << "\nSet time boundary.\n" << std::endl;
-                MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-            }
-
-            domain.SetTimeBoundary(t);
-        }
-
-        if (procRank == procsCount - 1)
-        {
-            if (printTimeSteps)
-            {
-                std::stringstream str;
-                str << "ProcRank = " << procRank << "\nApproximate time boundary.\n" << std::endl;
-                MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-            }
-
-            domain.ApproximateTimeBoundary(t);
-        }
-
-        if (printTimeSteps)
+        solver.AddCallback(1, [&log, procRank](const TransferSolver& solver)
         {
             std::stringstream str;
-            str << "ProcRank = " << procRank << "\nTime = " << t << std::endl;
-            str << domain.Print(Time::Curr).str();
+            str << "ProcRank = " << procRank << "\nTime = " << solver.GetTime() << "\n";
+            for (double value : solver.GetValues())
+                str << " " << value;
+            str << "\n" << std::endl;
             MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-        }
-
-        if (procRank % 2 == 1)
-        {
-            if (printTimeSteps)
-            {
-                std::stringstream str;
-                str << "ProcRank = " << procRank << "\nRecv start cell.\n" << std::endl;
-                MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-            }
-
-            MPI_Recv(&startCellReceiver, 1, MPI_DOUBLE, procRank - 1, SyncBoundary, MPI_COMM_WORLD, nullptr);
-            domain.SetStartBoundary(startCellReceiver);
-
-            if (printTimeSteps)
-            {
-                std::stringstream str;
-                str << "ProcRank = " << procRank << "\nSend start cell.\n" << std::endl;
-                MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-            }
-
-            startCellSender = domain.GetStartInnerCell();
-            MPI_Isend(&startCellSender, 1, MPI_DOUBLE, procRank - 1, SyncBoundary, MPI_COMM_WORLD, &startRequest);
-
-            if (procRank + 1 < procsCount)
-            {
-                if (printTimeSteps)
-                {
-                    std::stringstream str;
-                    str << "ProcRank = " << procRank << "\nSend stop cell.\n" << std::endl;
-                    MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-                }
-
-                stopCellSender = domain.GetStopInnerCell();
-                MPI_Isend(&stopCellSender, 1, MPI_DOUBLE, procRank + 1, SyncBoundary, MPI_COMM_WORLD, &stopRequest);
-
-                if (printTimeSteps)
-                {
-                    std::stringstream str;
-                    str << "ProcRank = " << procRank << "\nRecv stop cell.\n" << std::endl;
-                    MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-                }
-                    
-                MPI_Recv(&stopCellReceiver, 1, MPI_DOUBLE, procRank + 1, SyncBoundary, MPI_COMM_WORLD, nullptr);
-                domain.SetStopBoundary(stopCellReceiver);
-            }
-
-            MPI_Wait(&startRequest, nullptr);
-        }
-        else
-        {
-            if (procRank + 1 < procsCount)
-            {
-                if (printTimeSteps)
-                {
-                    std::stringstream str;
-                    str << "ProcRank = " << procRank << "\nRecv stop cell.\n" << std::endl;
-                    MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-                }
-                    
-                MPI_Recv(&stopCellReceiver, 1, MPI_DOUBLE, procRank + 1, SyncBoundary, MPI_COMM_WORLD, nullptr);
-                domain.SetStopBoundary(stopCellReceiver);
-            }
-
-            if (procRank - 1 > 0)
-            {
-                if (printTimeSteps)
-                {
-                    std::stringstream str;
-                    str << "ProcRank = " << procRank << "\nRecv start cell.\n" << std::endl;
-                    MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-                }
-                    
-                MPI_Recv(&startCellReceiver, 1, MPI_DOUBLE, procRank - 1, SyncBoundary, MPI_COMM_WORLD, nullptr);
-                domain.SetStartBoundary(startCellReceiver);
-
-                if (printTimeSteps)
-                {
-                    std::stringstream str;
-                    str << "ProcRank = " << procRank << "\nSend start cell.\n" << std::endl;
-                    MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-                }
-
-                startCellSender = domain.GetStartInnerCell();
-                MPI_Ssend(&startCellSender, 1, MPI_DOUBLE, procRank - 1, SyncBoundary, MPI_COMM_WORLD);
-            }
-        }
-
-        domain.NextTimeStep();
-        t += tau;
+        });
     }
 
-    if (procRank != 0)
-    {
-        if (printTimeSteps)
-        {
-            std::stringstream str;
-            str << "ProcRank = " << procRank << "\nSend results.\n" << std::endl;
-            MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-        }
-        
-        MPI_Ssend(domain.GetMesh().GetInnerCells(), meshSize * sizeof(Mesh::MeshCell), MPI_CHAR, 0, SyncWrite, MPI_COMM_WORLD);
+    solver.RunUntil(T);
 
-        if (procRank == procsCount - 1)
-            MPI_Ssend(domain.GetRightCell(), sizeof(Mesh::MeshCell), MPI_CHAR, 0, SyncEndBoundary, MPI_COMM_WORLD);
-    }
-    else
-    {
-        auto fullMesh = std::make_unique<Mesh::MeshCell[]>(MeshXPoints * 2);
-        fullMesh[0] = *domain.GetLeftCell();
+    PrintCounters("RANK[" + std::to_string(procRank) + "]");
 
-        for (size_t st = 0; st < meshSize; st++)
-            fullMesh.get()[st + 1] = domain.GetMesh().GetInnerCells()[st];
-
-        if (printTimeSteps)
-        {
-            std::stringstream str;
-            str << "ProcRank = " << procRank << "\nRecv results.\n" << std::endl;
-            MPI_File_write_shared(log, str.str().c_str(), str.tellp(), MPI_CHAR, MPI_STATUS_IGNORE);
-        }
-
-        for (int st = 1; st < procsCount - 1; st++)
-            MPI_Recv(fullMesh.get() + meshSize * st + 1, meshSize * sizeof(Mesh::MeshCell), MPI_CHAR, st, SyncWrite, MPI_COMM_WORLD, nullptr);
-
-        if (procsCount - 1 > 0)
-        {
-            MPI_Recv(fullMesh.get() + 1 + meshSize * (procsCount - 1), lastMeshSize * sizeof(Mesh::MeshCell), MPI_CHAR, procsCount - 1, SyncWrite, MPI_COMM_WORLD, nullptr);
-
-            Mesh::MeshCell RB = {};
-            MPI_Recv(&RB, sizeof(Mesh::MeshCell), MPI_DOUBLE, procsCount - 1, SyncEndBoundary, MPI_COMM_WORLD, nullptr);
-            fullMesh[MeshXPoints + 1] = RB;
-        }
-        else
-            fullMesh[MeshXPoints + 1] = *domain.GetRightCell();
+    std::vector<double> fullMesh = solver.Gather();
 
+    if (procRank == 0)
+    {
         std::ofstream outFile;
         outFile << std::fixed;
         outFile.open("result.txt", std::ios::out);
@@ -314,16 +83,23 @@ int main(int argc, char* argv[])
             {
                 outFile 
                     << " "
-                    << t - tau
+                    << solver.GetTime()
                     << " "
-                    << fullMesh.get()[st].x
+                    << h * st
                     << " "
-                    << fullMesh.get()[st].GetValue(Time::Prev, domain.GetMesh().GetType()) << "\n";
+                    << fullMesh[st] << "\n";
             }
             outFile.close();
         }
 
         double stopTime = MPI_Wtime();
+        RunMetrics metrics;
+        metrics
+            .Add("time", stopTime - startTime)
+            .Add("procs", procsCount)
+            .Add("points", MeshXPoints);
+        AddCounterMetrics(metrics);
+        metrics.Save();
 
         {
             std::stringstream str;
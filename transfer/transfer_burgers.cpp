@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <mpi.h>
+
+#include "../common/metrics.h"
+#include "double.h"
+#include "constant.h"
+#include "burgers.h"
+#include "mesh.h"
+
+const int SyncBoundary = 1;
+
+int main(int argc, char* argv[])
+{
+    double startTime = MPI_Wtime();
+
+    int procRank = 0;
+    int procsCount = 0;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &procsCount);
+    MPI_Comm_rank(MPI_COMM_WORLD, &procRank);
+
+    Limiter limiter = Limiter::Minmod;
+    if (argc > 1 && strcmp(argv[1], "superbee") == 0)
+        limiter = Limiter::Superbee;
+    else if (argc > 1 && strcmp(argv[1], "minmod") != 0)
+    {
+        if (procRank == 0)
+            std::cout << "Enter limiter as the first argument: minmod (default) or superbee." << std::endl;
+        MPI_Finalize();
+        return -1;
+    }
+
+    // Same rank decomposition as the linear solver.
+    size_t indMeshSize = MeshXPoints / procsCount;
+    size_t meshSize = indMeshSize;
+    size_t lastMeshSize = meshSize +  MeshXPoints - meshSize * procsCount;
+    if (procRank == procsCount - 1)
+        meshSize = lastMeshSize;
+
+    double x1 = procRank * indMeshSize * h;
+    BurgersDomain domain{meshSize, x1, limiter};
+
+    const int prevRank = procRank > 0 ? procRank - 1 : MPI_PROC_NULL;
+    const int nextRank = procRank + 1 < procsCount ? procRank + 1 : MPI_PROC_NULL;
+
+    double t = 0;
+    size_t timeSteps = 0;
+
+    while (!Double::IsEqual(t, T))
+    {
+        // Global CFL time step controller.
+        double maxSpeed = domain.GetMaxSpeed();
+        MPI_Allreduce(MPI_IN_PLACE, &maxSpeed, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+        double dt = T - t;
+        if (maxSpeed > 0)
+            dt = std::min(dt, BurgersCourant * h / maxSpeed);
+
+        domain.ComputeCells(dt);
+        t += dt;
+
+        if (procRank == 0)
+            domain.SetTimeBoundary(t);
+
+        if (procRank == procsCount - 1)
+            domain.ApproximateTimeBoundary();
+
+        MPI_Sendrecv(domain.GetStopInnerCells(), BurgersGhostCells, MPI_DOUBLE, nextRank, SyncBoundary,
+                     domain.GetStartBoundary(),  BurgersGhostCells, MPI_DOUBLE, prevRank, SyncBoundary,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        MPI_Sendrecv(domain.GetStartInnerCells(), BurgersGhostCells, MPI_DOUBLE, prevRank, SyncBoundary,
+                     domain.GetStopBoundary(),    BurgersGhostCells, MPI_DOUBLE, nextRank, SyncBoundary,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        domain.NextTimeStep();
+        timeSteps++;
+    }
+
+    std::vector<int> counts;
+    std::vector<int> displs;
+    std::vector<double> fullMesh;
+    if (procRank == 0)
+    {
+        counts.resize(procsCount, indMeshSize);
+        counts.back() = lastMeshSize;
+        displs.resize(procsCount);
+        for (int st = 0; st < procsCount; st++)
+            displs[st] = st * indMeshSize;
+        fullMesh.resize(MeshXPoints);
+    }
+
+    MPI_Gatherv(domain.GetMesh().GetLayer(Time::Prev), meshSize, MPI_DOUBLE,
+                fullMesh.data(), counts.data(), displs.data(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    if (procRank == 0)
+    {
+        std::ofstream outFile;
+        outFile << std::fixed;
+        outFile.open("result.txt", std::ios::out);
+        if (outFile.is_open())
+        {
+            outFile
+                << "t x u\n";
+            for (size_t st = 0; st < MeshXPoints; st++)
+            {
+                outFile
+                    << " "
+                    << t
+                    << " "
+                    << h * (st + 1)
+                    << " "
+                    << fullMesh[st] << "\n";
+            }
+            outFile.close();
+        }
+
+        double stopTime = MPI_Wtime();
+        RunMetrics()
+            .Add("time", stopTime - startTime)
+            .Add("procs", procsCount)
+            .Add("points", MeshXPoints)
+            .Save();
+
+        std::ofstream log;
+        log.open("log.txt", std::ios::out | std::ios::trunc);
+        log << "Mesh:\n"
+            << "\tX [0, " << X << "] m, step = h = " << h << " m\n"
+            << "\tT [0, " << T << "] s, time steps = " << timeSteps << "\n"
+            << "Courant number = " << BurgersCourant << "\n"
+            << "Limiter = " << (limiter == Limiter::Minmod ? "minmod" : "superbee") << "\n"
+            << "\n"
+            << "Procs count = " << procsCount << "\n"
+            << "Execution time = " << stopTime - startTime << " sec" << std::endl;
+        log.close();
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "aligned.h"
+#include "functions.h"
+
+// Convergence check of the variable velocity scheme ComputeCellsCentral4Points().
+// u_t + a(x, t) u_x = 0 on the periodic X = [0, 1) with a(x, t) = VelocityProfile(x) * VelocityModulation(t),
+// u(0, x) = sin(2 pi x). The error at T must decay as h^2 with tau = CourantLimit * h.
+
+const double T = 1;
+const double CourantLimit = 0.4;
+// Substeps of the characteristics of the exact solution.
+const size_t CharacteristicSteps = 1000;
+
+static double VelocityProfile(double x)
+{
+    return 1 + 0.5 * sin(M_PI * 2 * x);
+}
+
+static double VelocityModulation(double t, bool timeDependent)
+{
+    return timeDependent ? 1 + 0.5 * sin(M_PI * 2 * t) : 1;
+}
+
+static double ComputeInitial(double x)
+{
+    return sin(M_PI * 2 * x);
+}
+
+// u(x, T) = u(x(0), 0) for the characteristic dx/dt = a(x, t) through (x, T), integrated back by RK4.
+static double ComputeExact(double x, bool timeDependent)
+{
+    const double dt = -T / CharacteristicSteps;
+    double t = T;
+    for (size_t st = 0; st < CharacteristicSteps; st++)
+    {
+        double k1 = VelocityProfile(x) * VelocityModulation(t, timeDependent);
+        double k2 = VelocityProfile(x + dt / 2 * k1) * VelocityModulation(t + dt / 2, timeDependent);
+        double k3 = VelocityProfile(x + dt / 2 * k2) * VelocityModulation(t + dt / 2, timeDependent);
+        double k4 = VelocityProfile(x + dt * k3) * VelocityModulation(t + dt, timeDependent);
+        x += dt / 6 * (k1 + 2 * k2 + 2 * k3 + k4);
+        t += dt;
+    }
+    return ComputeInitial(x);
+}
+
+// Max error at T on the mesh of cellsCount cells, the same layout and modulation time as Domain.
+static double ComputeError(size_t cellsCount, bool timeDependent)
+{
+    const double h = 1.0 / cellsCount;
+    const size_t timeSteps = static_cast<size_t>(std::ceil(T / (CourantLimit * h)));
+    const double tau = T / timeSteps;
+
+    AlignedLayer first(cellsCount);
+    AlignedLayer second(cellsCount);
+    AlignedLayer co(cellsCount);
+    AlignedLayer coFace(cellsCount);
+
+    double* u_k  = first.Inner();
+    double* u_k1 = second.Inner();
+    for (size_t st = 0; st < cellsCount; st++)
+    {
+        u_k[st] = ComputeInitial(h * st);
+        co.Inner()[st] = VelocityProfile(h * st) * tau / h;
+        coFace.Inner()[st] = VelocityProfile(h * st + h / 2) * tau / h;
+    }
+    coFace.Inner()[-1] = coFace.Inner()[cellsCount - 1];
+
+    double t = 0;
+    for (size_t step = 0; step < timeSteps; step++)
+    {
+        u_k[-1] = u_k[cellsCount - 1];
+        u_k[cellsCount] = u_k[0];
+
+        ComputeCellsCentral4Points(u_k, u_k1, co.Inner(), coFace.Inner(),
+                                   VelocityModulation(t + tau / 2, timeDependent), tau, nullptr, cellsCount);
+        std::swap(u_k, u_k1);
+        t += tau;
+    }
+
+    double error = 0;
+    for (size_t st = 0; st < cellsCount; st++)
+        error = std::max(error, std::abs(u_k[st] - ComputeExact(h * st, timeDependent)));
+    return error;
+}
+
+int main()
+{
+    bool converged = true;
+    for (bool timeDependent : { false, true })
+    {
+        std::cout << (timeDependent ? "a(x, t) = a(x) s(t):" : "a(x, t) = a(x):") << "\n"
+                  << "\tcells\terror\t\torder\n";
+
+        double prevError = 0;
+        for (size_t cellsCount = 100; cellsCount <= 1600; cellsCount *= 2)
+        {
+            double error = ComputeError(cellsCount, timeDependent);
+            std::cout << "\t" << cellsCount << "\t" << error;
+            if (prevError > 0)
+            {
+                double order = std::log2(prevError / error);
+                std::cout << "\t" << order;
+                if (order < 1.8)
+                    converged = false;
+            }
+            std::cout << "\n";
+            prevError = error;
+        }
+    }
+
+    std::cout << (converged ? "Second order convergence." : "The scheme is not second order.") << std::endl;
+    return converged ? 0 : -1;
+}
\ No newline at end of file
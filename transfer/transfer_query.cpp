@@ -0,0 +1,72 @@
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../common/metrics.h"
+#include "constant.h"
+#include "query.h"
+
+int main(int argc, char* argv[])
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    if (argc < 3 || argc % 2 != 1)
+    {
+        std::cout
+            << "Enter query points as pairs of arguments: x1 t1 [x2 t2 ...].\n"
+            << "The solution is computed only in the domains of dependence of these points."
+            << std::endl;
+        return -1;
+    }
+
+    std::vector<PointQuery> queries;
+    for (int st = 1; st + 1 < argc; st += 2)
+        queries.push_back({ std::stod(argv[st]), std::stod(argv[st + 1]), 0 });
+
+    DependenceQuery query;
+    query.Compute(queries);
+
+    auto stopTime = std::chrono::high_resolution_clock::now();
+
+    size_t cellsComputed = query.GetCellsComputed();
+    size_t fullCells = query.GetFullCellsCount(queries);
+    RunMetrics()
+        .Add("time", std::chrono::duration<double>(stopTime - startTime).count())
+        .Add("queries", queries.size())
+        .Add("cells", cellsComputed)
+        .Save();
+
+    std::cout
+        << "Mesh:\n"
+        << "\tX [0, " << X << "] m, step = h   = " << h << " m\n"
+        << "\tT [0, " << T << "] s, step = tau = " << tau << " s\n"
+        << "Queries count  = " << queries.size() << "\n"
+        << "Cells computed = " << cellsComputed << "\n"
+        << "Full mesh      = " << fullCells << " cells, "
+        << static_cast<double>(fullCells) / cellsComputed << " times more\n"
+        << std::endl;
+
+    std::ofstream outFile;
+    outFile << std::fixed;
+    outFile.open("result.txt", std::ios::out);
+    if (outFile.is_open())
+    {
+        outFile
+            << "t x u\n";
+        for (const PointQuery& point : queries)
+            outFile << " " << point.t << " " << point.x << " " << point.Value << "\n";
+        outFile.close();
+    }
+
+    for (const PointQuery& point : queries)
+        std::cout << "u(" << point.x << ", " << point.t << ") = " << point.Value << "\n";
+
+    std::cout
+        << "\nExecution time = "
+        << std::chrono::duration<double>(stopTime - startTime).count()
+        << " sec" << std::endl;
+
+    return 0;
+}
\ No newline at end of file
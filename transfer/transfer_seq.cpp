@@ -2,6 +2,7 @@
 #include <fstream>
 #include <mpi.h>
 
+#include "../common/counters.h"
 #include "double.h"
 #include "constant.h"
 #include "domain.h"
@@ -21,10 +22,8 @@ int main()
 
     size_t meshSize = MeshXPoints;
 
-    Direction direction = Direction::Inv;
-
     double x1 = 0;
-    Domain domain{meshSize, x1, direction};
+    Domain domain{meshSize, x1, h, tau};
     
     double t = tau;
 
@@ -36,30 +35,32 @@ int main()
         domain.Print(Time::Prev);
     }
 
-    while (Double::IsLessEqual(t, T))
     {
-        domain.ComputeStartBoundary(t);
+        CounterRegion region("TimeSteps");
+        while (Double::IsLessEqual(t, T))
+        {
+            domain.ComputeStartBoundary(t);
 
-        domain.ComputeInnerCells(t);
-        domain.ComputeStopBoundary(t);
+            domain.ComputeInnerCells(t);
+            domain.ComputeStopBoundary(t);
 
-        domain.SetTimeBoundary(t);
-        domain.ApproximateTimeBoundary(t);
+            domain.SetTimeBoundary(t);
+            domain.ApproximateTimeBoundary(t);
 
-        if (printTimeSteps)
-        {
-            std::cout << "Time = " << t << std::endl;
-            domain.Print(Time::Curr);
-        }
+            if (printTimeSteps)
+            {
+                std::cout << "Time = " << t << std::endl;
+                domain.Print(Time::Curr);
+            }
 
-        domain.NextTimeStep();
-        t += tau;
+            domain.NextTimeStep();
+            region.AddFlops(domain.GetInnerCellsFlops());
+            t += tau;
+        }
     }
 
-    auto fullMesh = std::make_unique<Mesh::MeshCell[]>(MeshXPoints);
-
-    for (size_t st = 0; st < meshSize; st++)
-        fullMesh.get()[st] = domain.GetMesh().GetInnerCells()[st];
+    const double* values = domain.GetMesh().GetLayer(Time::Prev);
+    const double* coords = domain.GetMesh().GetX();
 
     std::ofstream outFile;
     outFile << std::fixed;
@@ -74,16 +75,24 @@ int main()
                 << " "
                 << t - tau
                 << " "
-                << fullMesh.get()[st].x
+                << coords[st]
                 << " "
-                << fullMesh.get()[st].GetValue(Time::Prev, domain.GetMesh().GetType()) << "\n";
+                << values[st] << "\n";
         }
     }
     outFile.close();
 
     double stopTime = MPI_Wtime();
+    RunMetrics metrics;
+    metrics
+        .Add("time", stopTime - startTime)
+        .Add("procs", 1)
+        .Add("points", MeshXPoints);
+    AddCounterMetrics(metrics);
+    metrics.Save();
 
     std::cout << "Execution time = " << stopTime - startTime << " sec" << std::endl;
+    PrintCounters("MAIN");
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <mpi.h>
+
+#include "../common/metrics.h"
+#include "double.h"
+#include "constant.h"
+#include "systems.h"
+
+const int SyncBoundary = 1;
+
+const size_t Fields = 2;
+
+int main(int argc, char* argv[])
+{
+    double startTime = MPI_Wtime();
+
+    int procRank = 0;
+    int procsCount = 0;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &procsCount);
+    MPI_Comm_rank(MPI_COMM_WORLD, &procRank);
+
+    HyperbolicSystem<Fields> system = {};
+    if (argc > 1 && strcmp(argv[1], "shallow_water") == 0)
+        system = MakeShallowWaterSystem(0.1, 0);
+    else if (argc == 1 || strcmp(argv[1], "acoustics") == 0)
+        system = MakeAcousticsSystem(a * a, 1);
+    else
+    {
+        if (procRank == 0)
+            std::cout << "Enter model as the first argument: acoustics (default) or shallow_water." << std::endl;
+        MPI_Finalize();
+        return -1;
+    }
+
+    // Same rank decomposition as the scalar solver.
+    size_t indMeshSize = MeshXPoints / procsCount;
+    size_t meshSize = indMeshSize;
+    size_t lastMeshSize = meshSize +  MeshXPoints - meshSize * procsCount;
+    if (procRank == procsCount - 1)
+        meshSize = lastMeshSize;
+
+    double x1 = procRank * indMeshSize * h;
+    SystemDomain<Fields> domain{meshSize, x1, system};
+    domain.SetSpatialBoundary(ComputeSystemPulse);
+
+    const int prevRank = procRank > 0 ? procRank - 1 : MPI_PROC_NULL;
+    const int nextRank = procRank + 1 < procsCount ? procRank + 1 : MPI_PROC_NULL;
+
+    // All fields of a boundary cell go in one message.
+    double startCellSender[Fields]   = {};
+    double stopCellSender[Fields]    = {};
+    double startCellReceiver[Fields] = {};
+    double stopCellReceiver[Fields]  = {};
+
+    double t = tau;
+
+    while (Double::IsLessEqual(t, T))
+    {
+        domain.ComputeCells();
+
+        domain.GetStartInnerCell(startCellSender);
+        domain.GetStopInnerCell(stopCellSender);
+
+        MPI_Sendrecv(stopCellSender,    Fields, MPI_DOUBLE, nextRank, SyncBoundary,
+                     startCellReceiver, Fields, MPI_DOUBLE, prevRank, SyncBoundary,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        MPI_Sendrecv(startCellSender,   Fields, MPI_DOUBLE, prevRank, SyncBoundary,
+                     stopCellReceiver,  Fields, MPI_DOUBLE, nextRank, SyncBoundary,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        if (procRank == 0)
+            domain.ApproximateStartBoundary();
+        else
+            domain.SetStartBoundary(startCellReceiver);
+
+        if (procRank == procsCount - 1)
+            domain.ApproximateStopBoundary();
+        else
+            domain.SetStopBoundary(stopCellReceiver);
+
+        domain.NextTimeStep();
+        t += tau;
+    }
+
+    // Cells are gathered as Fields values each.
+    std::vector<double> localMesh(meshSize * Fields);
+    for (size_t st = 0; st < meshSize; st++)
+        domain.GetMesh().GetCell(st, Time::Prev, localMesh.data() + st * Fields);
+
+    std::vector<int> counts;
+    std::vector<int> displs;
+    std::vector<double> fullMesh;
+    if (procRank == 0)
+    {
+        counts.resize(procsCount, indMeshSize * Fields);
+        counts.back() = lastMeshSize * Fields;
+        displs.resize(procsCount);
+        for (int st = 0; st < procsCount; st++)
+            displs[st] = st * indMeshSize * Fields;
+        fullMesh.resize(MeshXPoints * Fields);
+    }
+
+    MPI_Gatherv(localMesh.data(), meshSize * Fields, MPI_DOUBLE,
+                fullMesh.data(), counts.data(), displs.data(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    if (procRank == 0)
+    {
+        std::ofstream outFile;
+        outFile << std::fixed;
+        outFile.open("result.txt", std::ios::out);
+        if (outFile.is_open())
+        {
+            outFile
+                << "t x";
+            for (size_t field = 0; field < Fields; field++)
+                outFile << " u" << field;
+            outFile << "\n";
+
+            for (size_t st = 0; st < MeshXPoints; st++)
+            {
+                outFile
+                    << " "
+                    << t - tau
+                    << " "
+                    << h * (st + 1);
+                for (size_t field = 0; field < Fields; field++)
+                    outFile << " " << fullMesh[st * Fields + field];
+                outFile << "\n";
+            }
+            outFile.close();
+        }
+
+        double stopTime = MPI_Wtime();
+        RunMetrics()
+            .Add("time", stopTime - startTime)
+            .Add("procs", procsCount)
+            .Add("points", MeshXPoints)
+            .Save();
+
+        std::ofstream log;
+        log.open("log.txt", std::ios::out | std::ios::trunc);
+        log << "Mesh:\n"
+            << "\tX [0, " << X << "] m, step = h   = " << h << " m\n"
+            << "\tT [0, " << T << "] s, step = tau = " << tau << " s\n"
+            << "Fields = " << Fields << "\n"
+            << "Max Courant number = " << domain.GetMaxCourant() << "\n"
+            << "\n"
+            << "Procs count = " << procsCount << "\n"
+            << "Execution time = " << stopTime - startTime << " sec" << std::endl;
+        log.close();
+    }
+
+    MPI_Finalize();
+
+    return 0;
+}
\ No newline at end of file